@@ -27,8 +27,12 @@
       'sources': [
         'media/media_ozone_platform_wayland.cc',
         'media/media_ozone_platform_wayland.h',
+        'platform/client_native_pixmap_dmabuf.cc',
+        'platform/client_native_pixmap_dmabuf.h',
 	'platform/client_native_pixmap_factory_wayland.cc',
 	'platform/client_native_pixmap_factory_wayland.h',
+        'platform/cursor_factory_wayland.cc',
+        'platform/cursor_factory_wayland.h',
         'platform/desktop_platform_screen.h',
 	'platform/desktop_platform_screen_delegate.h',
         'platform/ozone_export_wayland.h',
@@ -37,10 +41,16 @@
 	'platform/message_generator.cc',
 	'platform/ozone_gpu_platform_support_host.h',
 	'platform/ozone_gpu_platform_support_host.cc',
+        'platform/overlay_manager_wayland.cc',
+        'platform/overlay_manager_wayland.h',
         'platform/ozone_platform_wayland.cc',
         'platform/ozone_platform_wayland.h',
+        'platform/ozone_wayland_canvas.cc',
+        'platform/ozone_wayland_canvas.h',
         'platform/ozone_wayland_window.cc',
         'platform/ozone_wayland_window.h',
+	'platform/wayland_frame_timing_stats.h',
+	'platform/wayland_input_event.h',
 	'platform/window_constants.h',
         'platform/window_manager_wayland.cc',
         'platform/window_manager_wayland.h',
@@ -15,6 +15,10 @@ if [ -n "$exists" ]; then
 fi
 
 git checkout -b $HACKING_BRANCH master
-git am $PATCH_DIR/00*
+if ! git am $PATCH_DIR/00*; then
+  git am --abort
+  echo "Ozone-Wayland: patches don't apply, check that src/ is at chromium_rev"
+  exit 1
+fi
 
 
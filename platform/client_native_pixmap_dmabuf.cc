@@ -0,0 +1,94 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/client_native_pixmap_dmabuf.h"
+
+#include <errno.h>
+#include <linux/types.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/trace_event/trace_event.h"
+
+// Only in linux/dma-buf.h of kernels 4.6 and later.
+#if !defined(DMA_BUF_IOCTL_SYNC)
+struct dma_buf_sync {
+  __u64 flags;
+};
+
+#define DMA_BUF_SYNC_READ (1 << 0)
+#define DMA_BUF_SYNC_WRITE (2 << 0)
+#define DMA_BUF_SYNC_RW (DMA_BUF_SYNC_READ | DMA_BUF_SYNC_WRITE)
+#define DMA_BUF_SYNC_START (0 << 2)
+#define DMA_BUF_SYNC_END (1 << 2)
+#define DMA_BUF_BASE 'b'
+#define DMA_BUF_IOCTL_SYNC _IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
+#endif
+
+namespace ui {
+
+namespace {
+
+void SyncDmabuf(int dmabuf_fd, uint64_t flags) {
+  struct dma_buf_sync sync = { 0 };
+  sync.flags = flags;
+  // Kernels without the ioctl keep the mapping coherent on their own.
+  if (HANDLE_EINTR(ioctl(dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync)) &&
+      errno != ENOTTY) {
+    PLOG(ERROR) << "DMA_BUF_IOCTL_SYNC failed";
+  }
+}
+
+}  // namespace
+
+// static
+scoped_ptr<ClientNativePixmap> ClientNativePixmapDmaBuf::ImportFromDmabuf(
+    base::ScopedFD dmabuf_fd,
+    const gfx::Size& size,
+    int stride) {
+  DCHECK_GE(stride, size.width() * 4);
+  size_t map_size = static_cast<size_t>(stride) * size.height();
+  void* data = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    dmabuf_fd.get(), 0);
+  if (data == MAP_FAILED) {
+    PLOG(ERROR) << "Failed to map dma-buf";
+    return nullptr;
+  }
+
+  return make_scoped_ptr<ClientNativePixmap>(
+      new ClientNativePixmapDmaBuf(dmabuf_fd.Pass(), stride, map_size, data));
+}
+
+ClientNativePixmapDmaBuf::ClientNativePixmapDmaBuf(base::ScopedFD dmabuf_fd,
+                                                   int stride,
+                                                   size_t map_size,
+                                                   void* data)
+    : dmabuf_fd_(dmabuf_fd.Pass()),
+      stride_(stride),
+      map_size_(map_size),
+      data_(data) {
+}
+
+ClientNativePixmapDmaBuf::~ClientNativePixmapDmaBuf() {
+  munmap(data_, map_size_);
+}
+
+void* ClientNativePixmapDmaBuf::Map() {
+  TRACE_EVENT0("ozone", "ClientNativePixmapDmaBuf::Map");
+  SyncDmabuf(dmabuf_fd_.get(), DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW);
+  return data_;
+}
+
+void ClientNativePixmapDmaBuf::Unmap() {
+  TRACE_EVENT0("ozone", "ClientNativePixmapDmaBuf::Unmap");
+  SyncDmabuf(dmabuf_fd_.get(), DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+}
+
+void ClientNativePixmapDmaBuf::GetStride(int* stride) const {
+  *stride = stride_;
+}
+
+}  // namespace ui
@@ -0,0 +1,51 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_CLIENT_NATIVE_PIXMAP_DMABUF_H_
+#define OZONE_PLATFORM_CLIENT_NATIVE_PIXMAP_DMABUF_H_
+
+#include "base/basictypes.h"
+#include "base/files/scoped_file.h"
+#include "base/memory/scoped_ptr.h"
+#include "ui/gfx/geometry/size.h"
+#include "ui/ozone/public/client_native_pixmap.h"
+
+namespace ui {
+
+// A linear GBM buffer object mapped into the client through its dma-buf.
+// CPU access between Map() and Unmap() is bracketed with DMA_BUF_IOCTL_SYNC,
+// so that caches are flushed before the GPU reads what was written.
+class ClientNativePixmapDmaBuf : public ClientNativePixmap {
+ public:
+  // Returns NULL if |dmabuf_fd| can't be mapped. Takes ownership of
+  // |dmabuf_fd|.
+  static scoped_ptr<ClientNativePixmap> ImportFromDmabuf(
+      base::ScopedFD dmabuf_fd,
+      const gfx::Size& size,
+      int stride);
+
+  ~ClientNativePixmapDmaBuf() override;
+
+  // ClientNativePixmap:
+  void* Map() override;
+  void Unmap() override;
+  void GetStride(int* stride) const override;
+
+ private:
+  ClientNativePixmapDmaBuf(base::ScopedFD dmabuf_fd,
+                           int stride,
+                           size_t map_size,
+                           void* data);
+
+  base::ScopedFD dmabuf_fd_;
+  int stride_;
+  size_t map_size_;
+  void* data_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClientNativePixmapDmaBuf);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_CLIENT_NATIVE_PIXMAP_DMABUF_H_
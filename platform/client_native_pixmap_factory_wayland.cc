@@ -4,12 +4,99 @@
 
 #include "ozone/platform/client_native_pixmap_factory_wayland.h"
 
+#include <vector>
+
+#include "base/logging.h"
+#include "ozone/platform/client_native_pixmap_dmabuf.h"
+#include "ui/gfx/native_pixmap_handle_ozone.h"
+#include "ui/ozone/public/client_native_pixmap_factory.h"
+
+#if !defined(ENABLE_DRM_SUPPORT)
 #include "ui/ozone/common/stub_client_native_pixmap_factory.h"
+#endif
 
 namespace ui {
 
+#if defined(ENABLE_DRM_SUPPORT)
+namespace {
+
+// Pixmaps which are only ever read by the GPU or the compositor.
+class ClientNativePixmapOpaque : public ClientNativePixmap {
+ public:
+  ClientNativePixmapOpaque() {}
+  ~ClientNativePixmapOpaque() override {}
+
+  // ClientNativePixmap:
+  void* Map() override {
+    NOTREACHED();
+    return nullptr;
+  }
+  void Unmap() override { NOTREACHED(); }
+  void GetStride(int* stride) const override { NOTREACHED(); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ClientNativePixmapOpaque);
+};
+
+// Maps the dma-bufs of linear GBM buffers created by the GPU process, see
+// WaylandDisplay::CreateNativePixmap. Needs no device, dma-bufs can be mapped
+// directly.
+class ClientNativePixmapFactoryWayland : public ClientNativePixmapFactory {
+ public:
+  ClientNativePixmapFactoryWayland() {}
+  ~ClientNativePixmapFactoryWayland() override {}
+
+  // ClientNativePixmapFactory:
+  void Initialize(base::ScopedFD device_fd) override {}
+
+  std::vector<Configuration> GetSupportedConfigurations() const override {
+    const Configuration kConfigurations[] = {
+      { gfx::BufferFormat::BGRA_8888, gfx::BufferUsage::MAP },
+      { gfx::BufferFormat::BGRA_8888, gfx::BufferUsage::PERSISTENT_MAP },
+      { gfx::BufferFormat::BGRA_8888, gfx::BufferUsage::SCANOUT },
+      { gfx::BufferFormat::BGRX_8888, gfx::BufferUsage::MAP },
+      { gfx::BufferFormat::BGRX_8888, gfx::BufferUsage::PERSISTENT_MAP },
+      { gfx::BufferFormat::BGRX_8888, gfx::BufferUsage::SCANOUT },
+      { gfx::BufferFormat::RGBA_8888, gfx::BufferUsage::MAP },
+      { gfx::BufferFormat::RGBA_8888, gfx::BufferUsage::PERSISTENT_MAP }
+    };
+    return std::vector<Configuration>(
+        kConfigurations, kConfigurations + arraysize(kConfigurations));
+  }
+
+  scoped_ptr<ClientNativePixmap> ImportFromHandle(
+      const gfx::NativePixmapHandle& handle,
+      const gfx::Size& size,
+      gfx::BufferUsage usage) override {
+    base::ScopedFD scoped_fd(handle.fd.fd);
+    switch (usage) {
+      case gfx::BufferUsage::MAP:
+      case gfx::BufferUsage::PERSISTENT_MAP:
+        return ClientNativePixmapDmaBuf::ImportFromDmabuf(scoped_fd.Pass(),
+                                                          size,
+                                                          handle.stride);
+      case gfx::BufferUsage::SCANOUT:
+        return make_scoped_ptr<ClientNativePixmap>(
+            new ClientNativePixmapOpaque);
+    }
+
+    NOTREACHED();
+    return nullptr;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ClientNativePixmapFactoryWayland);
+};
+
+}  // namespace
+#endif
+
 ClientNativePixmapFactory* CreateClientNativePixmapFactoryWayland() {
+#if defined(ENABLE_DRM_SUPPORT)
+  return new ClientNativePixmapFactoryWayland;
+#else
   return CreateStubClientNativePixmapFactory();
+#endif
 }
 
 }  // namespace ui
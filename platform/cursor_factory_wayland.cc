@@ -0,0 +1,130 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/cursor_factory_wayland.h"
+
+#include "ui/base/cursor/cursor.h"
+
+namespace ui {
+
+namespace {
+
+WaylandCursorType ToWaylandCursorType(int type) {
+  switch (type) {
+    case kCursorPointer:
+      return CURSOR_POINTER;
+    case kCursorCross:
+      return CURSOR_CROSS;
+    case kCursorHand:
+      return CURSOR_HAND;
+    case kCursorIBeam:
+      return CURSOR_IBEAM;
+    case kCursorWait:
+      return CURSOR_WAIT;
+    case kCursorHelp:
+      return CURSOR_HELP;
+    case kCursorProgress:
+      return CURSOR_PROGRESS;
+    case kCursorMove:
+      return CURSOR_MOVE;
+    case kCursorVerticalText:
+      return CURSOR_VERTICAL_TEXT;
+    case kCursorCell:
+      return CURSOR_CELL;
+    case kCursorContextMenu:
+      return CURSOR_CONTEXT_MENU;
+    case kCursorAlias:
+      return CURSOR_ALIAS;
+    case kCursorCopy:
+      return CURSOR_COPY;
+    case kCursorNoDrop:
+      return CURSOR_NO_DROP;
+    case kCursorNotAllowed:
+      return CURSOR_NOT_ALLOWED;
+    case kCursorZoomIn:
+      return CURSOR_ZOOM_IN;
+    case kCursorZoomOut:
+      return CURSOR_ZOOM_OUT;
+    case kCursorGrab:
+      return CURSOR_GRAB;
+    case kCursorGrabbing:
+      return CURSOR_GRABBING;
+    case kCursorNorthResize:
+      return CURSOR_NORTH_RESIZE;
+    case kCursorNorthEastResize:
+      return CURSOR_NORTH_EAST_RESIZE;
+    case kCursorEastResize:
+      return CURSOR_EAST_RESIZE;
+    case kCursorSouthEastResize:
+      return CURSOR_SOUTH_EAST_RESIZE;
+    case kCursorSouthResize:
+      return CURSOR_SOUTH_RESIZE;
+    case kCursorSouthWestResize:
+      return CURSOR_SOUTH_WEST_RESIZE;
+    case kCursorWestResize:
+      return CURSOR_WEST_RESIZE;
+    case kCursorNorthWestResize:
+      return CURSOR_NORTH_WEST_RESIZE;
+    case kCursorNorthSouthResize:
+      return CURSOR_NORTH_SOUTH_RESIZE;
+    case kCursorEastWestResize:
+      return CURSOR_EAST_WEST_RESIZE;
+    case kCursorNorthEastSouthWestResize:
+      return CURSOR_NORTH_EAST_SOUTH_WEST_RESIZE;
+    case kCursorNorthWestSouthEastResize:
+      return CURSOR_NORTH_WEST_SOUTH_EAST_RESIZE;
+    case kCursorColumnResize:
+      return CURSOR_COLUMN_RESIZE;
+    case kCursorRowResize:
+      return CURSOR_ROW_RESIZE;
+    default:
+      // Panning cursors and the like have no counterpart in cursor themes.
+      return CURSOR_NONE;
+  }
+}
+
+}  // namespace
+
+CursorFactoryWayland::CursorFactoryWayland() {
+}
+
+CursorFactoryWayland::~CursorFactoryWayland() {
+}
+
+// static
+WaylandCursorType CursorFactoryWayland::GetCursorType(PlatformCursor cursor) {
+  CursorFactoryWayland* factory =
+      static_cast<CursorFactoryWayland*>(CursorFactoryOzone::GetInstance());
+  std::map<PlatformCursor, WaylandCursorType>::const_iterator it =
+      factory->cursor_types_.find(cursor);
+  return it == factory->cursor_types_.end() ? CURSOR_NONE : it->second;
+}
+
+PlatformCursor CursorFactoryWayland::GetDefaultCursor(int type) {
+  PlatformCursor cursor = BitmapCursorFactoryOzone::GetDefaultCursor(type);
+  WaylandCursorType cursor_type = ToWaylandCursorType(type);
+  if (!cursor || cursor_type == CURSOR_NONE)
+    return cursor;
+
+  // Default cursors live as long as the factory.
+  std::map<PlatformCursor, WaylandCursorType>::iterator it =
+      cursor_types_.insert(std::make_pair(cursor, cursor_type)).first;
+  if (it->second == cursor_type)
+    return cursor;
+
+  // Types without a bitmap of their own get the one of the pointer, but the
+  // compositor's theme may still have a cursor for them.
+  scoped_refptr<BitmapCursorOzone>& shared = shared_bitmap_cursors_[type];
+  if (!shared.get()) {
+    scoped_refptr<BitmapCursorOzone> bitmap_cursor = GetBitmapCursor(cursor);
+    shared = new BitmapCursorOzone(bitmap_cursor->bitmaps(),
+                                   bitmap_cursor->hotspot(),
+                                   bitmap_cursor->frame_delay_ms());
+    cursor_types_[shared.get()] = cursor_type;
+  }
+
+  return shared.get();
+}
+
+}  // namespace ui
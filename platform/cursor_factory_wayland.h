@@ -0,0 +1,45 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_CURSOR_FACTORY_WAYLAND_H_
+#define OZONE_PLATFORM_CURSOR_FACTORY_WAYLAND_H_
+
+#include <map>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "ozone/platform/window_constants.h"
+#include "ui/base/cursor/ozone/bitmap_cursor_factory_ozone.h"
+
+namespace ui {
+
+// Bitmap cursor factory which also remembers which standard cursor type each
+// default cursor stands for. The GPU process can show those from the cursor
+// theme of the compositor, in which case their bitmaps are never sent to it.
+// Custom cursors only have bitmaps.
+class CursorFactoryWayland : public BitmapCursorFactoryOzone {
+ public:
+  CursorFactoryWayland();
+  ~CursorFactoryWayland() override;
+
+  // Returns the standard cursor |cursor| stands for, CURSOR_NONE for custom
+  // cursors.
+  static WaylandCursorType GetCursorType(PlatformCursor cursor);
+
+  // CursorFactoryOzone:
+  PlatformCursor GetDefaultCursor(int type) override;
+
+ private:
+  std::map<PlatformCursor, WaylandCursorType> cursor_types_;
+  // Cursors of standard types which share their bitmap with another type,
+  // keyed by the requested type. They have the same bitmaps, but stand for
+  // their own type.
+  std::map<int, scoped_refptr<BitmapCursorOzone>> shared_bitmap_cursors_;
+
+  DISALLOW_COPY_AND_ASSIGN(CursorFactoryWayland);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_CURSOR_FACTORY_WAYLAND_H_
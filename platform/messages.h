@@ -14,6 +14,8 @@
 #include "ipc/ipc_message_utils.h"
 #include "ipc/ipc_param_traits.h"
 #include "ipc/param_traits_macros.h"
+#include "ozone/platform/wayland_frame_timing_stats.h"
+#include "ozone/platform/wayland_input_event.h"
 #include "ozone/platform/window_constants.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "ui/events/event_constants.h"
@@ -30,6 +32,38 @@ IPC_ENUM_TRAITS_MAX_VALUE(ui::WidgetState,
                           ui::DESTROYED)
 IPC_ENUM_TRAITS_MAX_VALUE(ui::WidgetType,
                           ui::TOOLTIP)
+IPC_ENUM_TRAITS_MAX_VALUE(ui::WaylandCursorType,
+                          ui::CURSOR_TYPE_LAST)
+IPC_ENUM_TRAITS_MAX_VALUE(ui::WaylandInputEvent::Type,
+                          ui::WaylandInputEvent::SCROLL)
+
+IPC_STRUCT_TRAITS_BEGIN(ui::WaylandInputEvent)
+  IPC_STRUCT_TRAITS_MEMBER(type)
+  IPC_STRUCT_TRAITS_MEMBER(handle)
+  IPC_STRUCT_TRAITS_MEMBER(event_type)
+  IPC_STRUCT_TRAITS_MEMBER(flags)
+  IPC_STRUCT_TRAITS_MEMBER(x)
+  IPC_STRUCT_TRAITS_MEMBER(y)
+  IPC_STRUCT_TRAITS_MEMBER(x_offset)
+  IPC_STRUCT_TRAITS_MEMBER(y_offset)
+  IPC_STRUCT_TRAITS_MEMBER(touch_id)
+  IPC_STRUCT_TRAITS_MEMBER(time_stamp)
+  IPC_STRUCT_TRAITS_MEMBER(event_time)
+  IPC_STRUCT_TRAITS_MEMBER(capture_time)
+  IPC_STRUCT_TRAITS_MEMBER(send_time)
+IPC_STRUCT_TRAITS_END()
+
+IPC_STRUCT_TRAITS_BEGIN(ui::WaylandFrameTimingStats)
+  IPC_STRUCT_TRAITS_MEMBER(frames_swapped)
+  IPC_STRUCT_TRAITS_MEMBER(frames_presented)
+  IPC_STRUCT_TRAITS_MEMBER(frames_discarded)
+  IPC_STRUCT_TRAITS_MEMBER(frames_zero_copy)
+  IPC_STRUCT_TRAITS_MEMBER(latency_samples)
+  IPC_STRUCT_TRAITS_MEMBER(latency_sum_us)
+  IPC_STRUCT_TRAITS_MEMBER(latency_max_us)
+  IPC_STRUCT_TRAITS_MEMBER(jitter_sum_us)
+  IPC_STRUCT_TRAITS_MEMBER(refresh_ns)
+IPC_STRUCT_TRAITS_END()
 
 //------------------------------------------------------------------------------
 // Browser Messages
@@ -50,44 +84,35 @@ IPC_MESSAGE_CONTROL3(  // NOLINT(readability/fn_size)
     uint32_t /*key*/,
     int /*device_id*/)
 
-IPC_MESSAGE_CONTROL2(WaylandInput_MotionNotify,  // NOLINT(readability/fn_size)
-                     float /*x*/,
-                     float /*y*/)
+// Pointer and touch events collected between two protocol frame boundaries on
+// the GPU side, in the order they were received from the compositor.
+IPC_MESSAGE_CONTROL1(WaylandInput_EventBatch,  // NOLINT(readability/fn_size)
+                     std::vector<ui::WaylandInputEvent> /*events*/)
 
-IPC_MESSAGE_CONTROL5(WaylandInput_ButtonNotify,  // NOLINT(readability/fn_size)
-                     unsigned /*handle*/,
-                     ui::EventType /*type*/,
-                     ui::EventFlags /*flags*/,
-                     float /*x*/,
-                     float /*y*/)
-
-IPC_MESSAGE_CONTROL5(WaylandInput_TouchNotify,  // NOLINT(readability/fn_size)
-                     ui::EventType /*type*/,
-                     float /*x*/,
-                     float /*y*/,
-                     int32_t /*touch_id*/,
-                     uint32_t /*time_stamp*/)
-
-IPC_MESSAGE_CONTROL4(WaylandInput_AxisNotify,  // NOLINT(readability/fn_size)
-                     float /*x*/,
-                     float /*y*/,
-                     int /*x_offset*/,
-                     int /*y_offset*/)
-
-IPC_MESSAGE_CONTROL3(WaylandInput_PointerEnter,  // NOLINT(readability/fn_size)
-                     unsigned /*handle*/,
-                     float /*x*/,
-                     float /*y*/)
-
-IPC_MESSAGE_CONTROL3(WaylandInput_PointerLeave,  // NOLINT(readability/fn_size)
-                     unsigned /*handle*/,
-                     float /*x*/,
-                     float /*y*/)
+// Sent once per channel when the shared memory input ring is enabled. From
+// then on batches are written to the ring and WaylandInput_EventBatch is only
+// used when the ring is full. Ring records are stamped with the number of
+// messages of this file sent after this one, see WaylandInputEvent::sequence.
+IPC_MESSAGE_CONTROL3(WaylandInput_InputRingCreated,  // NOLINT(readability/
+                     base::SharedMemoryHandle /*ring*/,  //        fn_size)
+                     uint32_t /*size*/,
+                     base::FileDescriptor /*doorbell*/)
 
 IPC_MESSAGE_CONTROL2(WaylandInput_OutputSize,  // NOLINT(readability/fn_size)
                      unsigned /*width*/,
                      unsigned /*height*/)
 
+// Buffer formats the compositor can show as overlay planes, as a mask with
+// bit 1 << gfx::BufferFormat set for each, and whether it can scale them.
+IPC_MESSAGE_CONTROL2(WaylandInput_OverlayCapabilities,  // NOLINT(readability/
+                     uint32_t /*formats*/,              //        fn_size)
+                     bool /*scaling*/)
+
+// Standard cursors that can be set with WaylandDisplay_CursorSetType, bit N
+// standing for the ui::WaylandCursorType N.
+IPC_MESSAGE_CONTROL1(WaylandInput_CursorTheme,  // NOLINT(readability/fn_size)
+                     uint64_t /*themed_types*/)
+
 IPC_MESSAGE_CONTROL1(WaylandInput_CloseWidget,  // NOLINT(readability/fn_size)
                      unsigned /*handle*/)
 
@@ -105,6 +130,14 @@ IPC_MESSAGE_CONTROL1(WaylandWindow_DeActivated,  // NOLINT(readability/fn_size)
 IPC_MESSAGE_CONTROL1(WaylandWindow_Activated,  // NOLINT(readability/fn_size)
                      unsigned /*handle*/)
 
+IPC_MESSAGE_CONTROL2(WaylandWindow_CanvasBufferReleased,  // NOLINT(readability/
+                     unsigned /*handle*/,                 //        fn_size)
+                     uint32_t /*buffer_id*/)
+
+IPC_MESSAGE_CONTROL2(WaylandWindow_FrameTimingStats,  // NOLINT(readability/
+                     unsigned /*handle*/,             //        fn_size)
+                     ui::WaylandFrameTimingStats /*stats*/)
+
 IPC_MESSAGE_CONTROL2(WaylandInput_Commit,  // NOLINT(readability/fn_size)
                      unsigned,
                      std::string)
@@ -165,23 +198,36 @@ IPC_MESSAGE_CONTROL2(WaylandDisplay_Title,  // NOLINT(readability/fn_size)
                      unsigned /* window handle */,
                      base::string16 /* window title */)
 
-IPC_MESSAGE_CONTROL5(WaylandDisplay_AddRegion,  // NOLINT(readability/fn_size)
+// Replaces the opaque and input regions of the window. Both are lists of
+// non-overlapping rects in surface coordinates. An empty input list makes the
+// whole surface accept input, an empty opaque list marks it as translucent.
+IPC_MESSAGE_CONTROL3(WaylandDisplay_SetRegion,  // NOLINT(readability/fn_size)
                      unsigned /* window handle */,
-                     int /* left */,
-                     int /* top */,
-                     int /* right */,
-                     int /* bottom */)
+                     std::vector<gfx::Rect> /* opaque region */,
+                     std::vector<gfx::Rect> /* input region */)
 
-IPC_MESSAGE_CONTROL5(WaylandDisplay_SubRegion,  // NOLINT(readability/fn_size)
-                     unsigned /* window handle */,
-                     int /* left */,
-                     int /* top */,
-                     int /* right */,
-                     int /* bottom */)
+// Sends the bitmaps of a cursor once, later changes to it only carry |id|.
+// Cursors with more than one bitmap are animated by the GPU process, showing
+// each for |frame_delay_ms|.
+IPC_MESSAGE_CONTROL4(WaylandDisplay_CursorRegister,  // NOLINT(readability/
+                                                     //         fn_size)
+                     uint32_t /* id */,
+                     std::vector<SkBitmap> /* bitmaps */,
+                     gfx::Point /* hotspot */,
+                     int /* frame_delay_ms */)
 
-IPC_MESSAGE_CONTROL2(WaylandDisplay_CursorSet,  // NOLINT(readability/fn_size)
-                     std::vector<SkBitmap>,
-                     gfx::Point)
+// Shows the cursor registered with |id|, 0 hides the cursor.
+IPC_MESSAGE_CONTROL1(WaylandDisplay_CursorSet,  // NOLINT(readability/fn_size)
+                     uint32_t /* id */)
+
+// Shows a standard cursor from the cursor theme of the compositor.
+IPC_MESSAGE_CONTROL1(WaylandDisplay_CursorSetType,  // NOLINT(readability/
+                                                    //         fn_size)
+                     ui::WaylandCursorType /* type */)
+
+// The browser freed the cursor registered with |id|.
+IPC_MESSAGE_CONTROL1(WaylandDisplay_CursorEvict,  // NOLINT(readability/fn_size)
+                     uint32_t /* id */)
 
 IPC_MESSAGE_CONTROL1(WaylandDisplay_MoveCursor,  // NOLINT(readability/fn_size)
                      gfx::Point)
@@ -207,3 +253,21 @@ IPC_MESSAGE_CONTROL2(WaylandDisplay_DragWillBeAccepted,  // NOLINT(readability/
 
 IPC_MESSAGE_CONTROL1(WaylandDisplay_DragWillBeRejected,  // NOLINT(readability/
                      uint32_t /* serial */)              //        fn_size)
+
+IPC_MESSAGE_CONTROL5(WaylandDisplay_CanvasBuffersCreated,  // NOLINT(readability/
+                     unsigned /* window handle */,         //        fn_size)
+                     base::FileDescriptor /* shm */,
+                     gfx::Size /* size */,
+                     uint32_t /* count */,
+                     uint32_t /* first buffer id */)
+
+IPC_MESSAGE_CONTROL3(WaylandDisplay_CanvasPresent,  // NOLINT(readability/
+                     unsigned /* window handle */,  //        fn_size)
+                     uint32_t /* buffer id */,
+                     gfx::Rect /* damage */)
+
+IPC_MESSAGE_CONTROL1(WaylandDisplay_CanvasDestroyed,  // NOLINT(readability/
+                     unsigned /* window handle */)    //        fn_size)
+
+IPC_MESSAGE_CONTROL1(WaylandDisplay_GetFrameTimingStats,  // NOLINT(readability/
+                     unsigned /* window handle */)        //        fn_size)
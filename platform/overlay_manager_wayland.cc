@@ -0,0 +1,113 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/overlay_manager_wayland.h"
+
+#include "ozone/platform/messages.h"
+#include "ozone/platform/ozone_gpu_platform_support_host.h"
+#include "ui/gfx/geometry/rect_conversions.h"
+
+namespace ui {
+
+namespace {
+
+class OverlayCandidatesWayland : public OverlayCandidatesOzone {
+ public:
+  explicit OverlayCandidatesWayland(const OverlayManagerWayland* manager)
+      : manager_(manager) {
+  }
+
+  ~OverlayCandidatesWayland() override {
+  }
+
+  // OverlayCandidatesOzone:
+  void CheckOverlaySupport(OverlaySurfaceList* candidates) override {
+    manager_->CheckOverlaySupport(candidates);
+  }
+
+ private:
+  const OverlayManagerWayland* manager_;  // Not owned.
+
+  DISALLOW_COPY_AND_ASSIGN(OverlayCandidatesWayland);
+};
+
+}  // namespace
+
+OverlayManagerWayland::OverlayManagerWayland(
+    OzoneGpuPlatformSupportHost* proxy)
+    : proxy_(proxy),
+      formats_(0),
+      scaling_(false) {
+  proxy_->RegisterHandler(this);
+}
+
+OverlayManagerWayland::~OverlayManagerWayland() {
+}
+
+void OverlayManagerWayland::CheckOverlaySupport(
+    OverlayCandidatesOzone::OverlaySurfaceList* candidates) const {
+  for (size_t i = 0; i < candidates->size(); ++i) {
+    OverlayCandidatesOzone::OverlaySurface& candidate = candidates->at(i);
+    // Planes are subsurfaces stacked above the window, the window itself is
+    // the main plane.
+    if (candidate.plane_z_order <= 0 ||
+        candidate.transform != gfx::OVERLAY_TRANSFORM_NONE ||
+        !(formats_ & (1u << static_cast<int>(candidate.format)))) {
+      continue;
+    }
+
+    gfx::Rect display_rect = gfx::ToNearestRect(candidate.display_rect);
+    if (gfx::RectF(display_rect) != candidate.display_rect ||
+        display_rect.IsEmpty()) {
+      continue;
+    }
+
+    if (!scaling_ && (display_rect.size() != candidate.buffer_size ||
+                      candidate.crop_rect != gfx::RectF(1, 1))) {
+      continue;
+    }
+
+    candidate.overlay_handled = true;
+  }
+}
+
+scoped_ptr<OverlayCandidatesOzone>
+OverlayManagerWayland::CreateOverlayCandidates(gfx::AcceleratedWidget w) {
+  return make_scoped_ptr<OverlayCandidatesOzone>(
+      new OverlayCandidatesWayland(this));
+}
+
+bool OverlayManagerWayland::CanShowPrimaryPlaneAsOverlay() {
+  return false;
+}
+
+void OverlayManagerWayland::OnChannelEstablished(
+    int host_id,
+    scoped_refptr<base::SingleThreadTaskRunner> send_runner,
+    const base::Callback<void(IPC::Message*)>& send_callback) {
+}
+
+void OverlayManagerWayland::OnChannelDestroyed(int host_id) {
+  // A new GPU process tells us again once it is up.
+  formats_ = 0;
+  scaling_ = false;
+}
+
+bool OverlayManagerWayland::OnMessageReceived(const IPC::Message& message) {
+  bool handled = true;
+  IPC_BEGIN_MESSAGE_MAP(OverlayManagerWayland, message)
+  IPC_MESSAGE_HANDLER(WaylandInput_OverlayCapabilities, OverlayCapabilities)
+  IPC_MESSAGE_UNHANDLED(handled = false)
+  IPC_END_MESSAGE_MAP()
+
+  return handled;
+}
+
+void OverlayManagerWayland::OverlayCapabilities(uint32_t formats,
+                                                bool scaling) {
+  formats_ = formats;
+  scaling_ = scaling;
+}
+
+}  // namespace ui
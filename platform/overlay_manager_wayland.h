@@ -0,0 +1,59 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_OVERLAY_MANAGER_WAYLAND_H_
+#define OZONE_PLATFORM_OVERLAY_MANAGER_WAYLAND_H_
+
+#include "base/basictypes.h"
+#include "ui/ozone/public/gpu_platform_support_host.h"
+#include "ui/ozone/public/overlay_candidates_ozone.h"
+#include "ui/ozone/public/overlay_manager_ozone.h"
+
+namespace ui {
+
+class OzoneGpuPlatformSupportHost;
+
+// Decides which overlay candidates the GPU process can show as subsurfaces of
+// the window, see ozonewayland::WaylandOverlayPlanes. The GPU process tells
+// which buffer formats the compositor can import and whether it can scale
+// them when the channel is established, so candidates are checked without a
+// roundtrip to the GPU process.
+class OverlayManagerWayland : public OverlayManagerOzone,
+                              public GpuPlatformSupportHost {
+ public:
+  explicit OverlayManagerWayland(OzoneGpuPlatformSupportHost* proxy);
+  ~OverlayManagerWayland() override;
+
+  // Marks the candidates in |candidates| which can be shown as overlays.
+  void CheckOverlaySupport(
+      OverlayCandidatesOzone::OverlaySurfaceList* candidates) const;
+
+  // OverlayManagerOzone:
+  scoped_ptr<OverlayCandidatesOzone> CreateOverlayCandidates(
+      gfx::AcceleratedWidget w) override;
+  bool CanShowPrimaryPlaneAsOverlay() override;
+
+  // GpuPlatformSupportHost:
+  void OnChannelEstablished(
+      int host_id,
+      scoped_refptr<base::SingleThreadTaskRunner> send_runner,
+      const base::Callback<void(IPC::Message*)>& send_callback) override;
+  void OnChannelDestroyed(int host_id) override;
+  bool OnMessageReceived(const IPC::Message& message) override;
+
+ private:
+  void OverlayCapabilities(uint32_t formats, bool scaling);
+
+  OzoneGpuPlatformSupportHost* proxy_;  // Not owned.
+  // Mask of the supported gfx::BufferFormats, 0 until the GPU process has
+  // told us.
+  uint32_t formats_;
+  bool scaling_;
+
+  DISALLOW_COPY_AND_ASSIGN(OverlayManagerWayland);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_OVERLAY_MANAGER_WAYLAND_H_
@@ -4,19 +4,22 @@
 
 #include "ozone/platform/ozone_platform_wayland.h"
 
+#include <stdlib.h>
+
 #include "base/at_exit.h"
 #include "base/bind.h"
+#include "base/command_line.h"
+#include "ozone/platform/cursor_factory_wayland.h"
+#include "ozone/platform/overlay_manager_wayland.h"
 #include "ozone/platform/ozone_gpu_platform_support_host.h"
 #include "ozone/platform/ozone_wayland_window.h"
 #include "ozone/platform/window_manager_wayland.h"
 #include "ozone/wayland/display.h"
 #include "ozone/wayland/ozone_wayland_screen.h"
-#include "ui/base/cursor/ozone/bitmap_cursor_factory_ozone.h"
 #include "ui/events/ozone/layout/keyboard_layout_engine_manager.h"
 #include "ui/events/ozone/layout/xkb/xkb_evdev_codes.h"
 #include "ui/events/ozone/layout/xkb/xkb_keyboard_layout_engine.h"
 #include "ui/ozone/common/native_display_delegate_ozone.h"
-#include "ui/ozone/common/stub_overlay_manager.h"
 #include "ui/ozone/public/system_input_injector.h"
 #include "ui/platform_window/platform_window_delegate.h"
 
@@ -24,6 +27,12 @@ namespace ui {
 
 namespace {
 
+// Scheduling policy of the Wayland display poll thread in the GPU process, see
+// WaylandPollThreadPolicy::FromString for the syntax. The environment variable
+// of the same name, in upper case, is used if the switch is not given.
+const char kOzoneWaylandPollThread[] = "ozone-wayland-poll-thread";
+const char kOzoneWaylandPollThreadEnv[] = "OZONE_WAYLAND_POLL_THREAD";
+
 // OzonePlatform for Wayland
 //
 // This platform is Linux with the Wayland display server.
@@ -88,6 +97,8 @@ class OzonePlatformWayland : public OzonePlatform {
   }
 
   base::ScopedFD OpenClientNativePixmapDevice() const override {
+    // Clients map the dma-bufs of native pixmaps directly, they don't need a
+    // device for that.
     return base::ScopedFD();
   }
 
@@ -99,26 +110,52 @@ class OzonePlatformWayland : public OzonePlatform {
     gpu_platform_host_.reset(new ui::OzoneGpuPlatformSupportHost());
     // Needed as Browser creates accelerated widgets through SFO.
     wayland_display_.reset(new ozonewayland::WaylandDisplay());
-    cursor_factory_ozone_.reset(new ui::BitmapCursorFactoryOzone());
-    overlay_manager_.reset(new StubOverlayManager());
+    cursor_factory_ozone_.reset(new ui::CursorFactoryWayland());
     KeyboardLayoutEngineManager::SetKeyboardLayoutEngine(make_scoped_ptr(
         new XkbKeyboardLayoutEngine(xkb_evdev_code_converter_)));
+    // The window manager keeps input from the ring in order with messages
+    // from the GPU process, so it has to be the first handler to see them.
     window_manager_.reset(
         new ui::WindowManagerWayland(gpu_platform_host_.get()));
+    overlay_manager_.reset(
+        new ui::OverlayManagerWayland(gpu_platform_host_.get()));
+    wayland_display_->SetCanvasFactory(
+        base::Bind(&WindowManagerWayland::CreateCanvas,
+                   base::Unretained(window_manager_.get())));
   }
 
   void InitializeGPU() override {
     if (!wayland_display_)
       wayland_display_.reset(new ozonewayland::WaylandDisplay());
 
+    wayland_display_->SetPollThreadPolicy(GetPollThreadPolicy());
     if (!wayland_display_->InitializeHardware())
       LOG(FATAL) << "failed to initialize display hardware";
   }
 
  private:
-  scoped_ptr<ui::BitmapCursorFactoryOzone> cursor_factory_ozone_;
+  ozonewayland::WaylandPollThreadPolicy GetPollThreadPolicy() const {
+    std::string value;
+    const base::CommandLine* command_line =
+        base::CommandLine::ForCurrentProcess();
+    if (command_line->HasSwitch(kOzoneWaylandPollThread)) {
+      value = command_line->GetSwitchValueASCII(kOzoneWaylandPollThread);
+    } else if (const char* env = getenv(kOzoneWaylandPollThreadEnv)) {
+      value = env;
+    }
+
+    ozonewayland::WaylandPollThreadPolicy policy;
+    if (!value.empty() &&
+        !ozonewayland::WaylandPollThreadPolicy::FromString(value, &policy)) {
+      LOG(WARNING) << "Invalid Wayland poll thread policy: " << value;
+    }
+
+    return policy;
+  }
+
+  scoped_ptr<ui::CursorFactoryWayland> cursor_factory_ozone_;
   scoped_ptr<ozonewayland::WaylandDisplay> wayland_display_;
-  scoped_ptr<StubOverlayManager> overlay_manager_;
+  scoped_ptr<ui::OverlayManagerWayland> overlay_manager_;
   scoped_ptr<ui::WindowManagerWayland> window_manager_;
   XkbEvdevCodes xkb_evdev_code_converter_;
   scoped_ptr<ui::OzoneGpuPlatformSupportHost> gpu_platform_host_;
@@ -0,0 +1,186 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/ozone_wayland_canvas.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/platform/messages.h"
+#include "ozone/platform/ozone_gpu_platform_support_host.h"
+#include "ozone/platform/window_manager_wayland.h"
+#include "third_party/skia/include/core/SkImageInfo.h"
+#include "ui/gfx/vsync_provider.h"
+
+namespace ui {
+
+namespace {
+
+// Three buffers let the browser draw while one frame is shown and the next
+// one waits for the compositor.
+const uint32_t kBufferCount = 3;
+const int kBytesPerPixel = 4;
+
+}  // namespace
+
+OzoneWaylandCanvas::Buffer::Buffer()
+    : pixels(NULL),
+      busy(false),
+      presented(0) {
+}
+
+OzoneWaylandCanvas::Buffer::~Buffer() {
+}
+
+OzoneWaylandCanvas::OzoneWaylandCanvas(gfx::AcceleratedWidget widget,
+                                       OzoneGpuPlatformSupportHost* sender,
+                                       WindowManagerWayland* window_manager)
+    : widget_(widget),
+      sender_(sender),
+      window_manager_(window_manager),
+      stride_(0),
+      first_buffer_id_(0),
+      current_(-1),
+      last_presented_(-1),
+      present_count_(0) {
+  window_manager_->OnCanvasCreated(widget_, this);
+}
+
+OzoneWaylandCanvas::~OzoneWaylandCanvas() {
+  window_manager_->OnCanvasDestroyed(widget_);
+  sender_->Send(new WaylandDisplay_CanvasDestroyed(widget_));
+}
+
+skia::RefPtr<SkSurface> OzoneWaylandCanvas::GetSurface() {
+  if (buffers_.empty())
+    return skia::RefPtr<SkSurface>();
+
+  if (current_ < 0)
+    SelectBuffer();
+
+  return buffers_[current_].surface;
+}
+
+void OzoneWaylandCanvas::ResizeCanvas(const gfx::Size& viewport_size) {
+  if (size_ == viewport_size && !buffers_.empty())
+    return;
+
+  size_ = viewport_size;
+  stride_ = size_.width() * kBytesPerPixel;
+  first_buffer_id_ += buffers_.size();
+  buffers_.clear();
+  shared_memory_.reset();
+  current_ = -1;
+  last_presented_ = -1;
+  if (size_.IsEmpty())
+    return;
+
+  size_t buffer_size = stride_ * size_.height();
+  shared_memory_.reset(new base::SharedMemory());
+  if (!shared_memory_->CreateAndMapAnonymous(buffer_size * kBufferCount)) {
+    LOG(ERROR) << "Failed to allocate canvas buffers of " << size_.ToString();
+    shared_memory_.reset();
+    return;
+  }
+
+  SkImageInfo info = SkImageInfo::MakeN32Premul(size_.width(),
+                                                size_.height());
+  uint8_t* memory = static_cast<uint8_t*>(shared_memory_->memory());
+  buffers_.resize(kBufferCount);
+  for (uint32_t i = 0; i < kBufferCount; ++i) {
+    buffers_[i].pixels = memory + i * buffer_size;
+    buffers_[i].surface = skia::AdoptRef(
+        SkSurface::NewRasterDirect(info, buffers_[i].pixels, stride_));
+  }
+
+  sender_->Send(new WaylandDisplay_CanvasBuffersCreated(
+      widget_,
+      base::FileDescriptor(dup(shared_memory_->handle().fd), true),
+      size_,
+      kBufferCount,
+      first_buffer_id_));
+}
+
+void OzoneWaylandCanvas::PresentCanvas(const gfx::Rect& damage) {
+  if (current_ < 0)
+    return;
+
+  gfx::Rect clipped = gfx::IntersectRects(damage, gfx::Rect(size_));
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    if (static_cast<int>(i) != current_)
+      buffers_[i].stale.Union(clipped);
+  }
+
+  Buffer& buffer = buffers_[current_];
+  buffer.busy = true;
+  buffer.presented = ++present_count_;
+  last_presented_ = current_;
+  sender_->Send(new WaylandDisplay_CanvasPresent(widget_,
+                                                 first_buffer_id_ + current_,
+                                                 clipped));
+  current_ = -1;
+}
+
+scoped_ptr<gfx::VSyncProvider> OzoneWaylandCanvas::CreateVSyncProvider() {
+  return scoped_ptr<gfx::VSyncProvider>();
+}
+
+void OzoneWaylandCanvas::OnBufferReleased(uint32_t buffer_id) {
+  uint32_t index = buffer_id - first_buffer_id_;
+  if (index < buffers_.size())
+    buffers_[index].busy = false;
+}
+
+void OzoneWaylandCanvas::SelectBuffer() {
+  // The most recently presented of the free buffers needs the least copying,
+  // the last presented one none at all if the compositor is done with it.
+  int selected = -1;
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    if (buffers_[i].busy)
+      continue;
+
+    if (selected < 0 || buffers_[i].presented > buffers_[selected].presented)
+      selected = i;
+  }
+
+  if (selected < 0) {
+    // The compositor holds on to all buffers. Draw into the one it got
+    // first, which it is least likely to still be reading.
+    TRACE_EVENT_INSTANT0("ozone", "OzoneWaylandCanvas::NoFreeBuffer",
+                         TRACE_EVENT_SCOPE_THREAD);
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      if (static_cast<int>(i) == last_presented_)
+        continue;
+
+      if (selected < 0 || buffers_[i].presented < buffers_[selected].presented)
+        selected = i;
+    }
+  }
+
+  current_ = selected;
+  Buffer& buffer = buffers_[current_];
+  if (last_presented_ >= 0 && current_ != last_presented_ &&
+      !buffer.stale.IsEmpty()) {
+    CopyRect(buffers_[last_presented_], &buffer, buffer.stale);
+  }
+
+  buffer.stale = gfx::Rect();
+}
+
+void OzoneWaylandCanvas::CopyRect(const Buffer& from,
+                                  Buffer* to,
+                                  const gfx::Rect& rect) {
+  TRACE_EVENT1("ozone", "OzoneWaylandCanvas::CopyRect",
+               "pixels", rect.size().GetArea());
+  size_t offset = rect.y() * stride_ + rect.x() * kBytesPerPixel;
+  size_t row_size = rect.width() * kBytesPerPixel;
+  for (int row = 0; row < rect.height(); ++row) {
+    memcpy(to->pixels + offset, from.pixels + offset, row_size);
+    offset += stride_;
+  }
+}
+
+}  // namespace ui
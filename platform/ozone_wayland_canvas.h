@@ -0,0 +1,87 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_OZONE_WAYLAND_CANVAS_H_
+#define OZONE_PLATFORM_OZONE_WAYLAND_CANVAS_H_
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "skia/ext/refptr.h"
+#include "third_party/skia/include/core/SkSurface.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/native_widget_types.h"
+#include "ui/ozone/public/surface_ozone_canvas.h"
+
+namespace ui {
+
+class OzoneGpuPlatformSupportHost;
+class WindowManagerWayland;
+
+// Software rendered surface of a window. Skia draws straight into buffers in
+// shared memory, which the GPU process wraps into wl_buffers and attaches to
+// the window's surface. Frames rotate through the buffers, and a buffer is
+// only drawn into again once the compositor has released it. The content
+// which a buffer missed while others were presented is copied over from the
+// last presented one, since the compositor only repaints the damage.
+class OzoneWaylandCanvas : public SurfaceOzoneCanvas {
+ public:
+  OzoneWaylandCanvas(gfx::AcceleratedWidget widget,
+                     OzoneGpuPlatformSupportHost* sender,
+                     WindowManagerWayland* window_manager);
+  ~OzoneWaylandCanvas() override;
+
+  // SurfaceOzoneCanvas:
+  skia::RefPtr<SkSurface> GetSurface() override;
+  void ResizeCanvas(const gfx::Size& viewport_size) override;
+  void PresentCanvas(const gfx::Rect& damage) override;
+  scoped_ptr<gfx::VSyncProvider> CreateVSyncProvider() override;
+
+  // Called when the compositor is done with buffer |buffer_id|.
+  void OnBufferReleased(uint32_t buffer_id);
+
+ private:
+  struct Buffer {
+    Buffer();
+    ~Buffer();
+
+    skia::RefPtr<SkSurface> surface;
+    uint8_t* pixels;
+    // Attached to the window's surface and not released yet.
+    bool busy;
+    // Value of |present_count_| when the buffer was last presented.
+    uint64_t presented;
+    // Area which changed in other buffers since this one was presented.
+    gfx::Rect stale;
+  };
+
+  // Picks the buffer to draw the next frame into and brings it up to date.
+  void SelectBuffer();
+  // Copies |rect| of buffer |from| to buffer |to|.
+  void CopyRect(const Buffer& from, Buffer* to, const gfx::Rect& rect);
+
+  gfx::AcceleratedWidget widget_;
+  OzoneGpuPlatformSupportHost* sender_;  // Not owned.
+  WindowManagerWayland* window_manager_;  // Not owned.
+  gfx::Size size_;
+  int stride_;
+  scoped_ptr<base::SharedMemory> shared_memory_;
+  std::vector<Buffer> buffers_;
+  // Id of |buffers_[0]|. Ids aren't reused, so that releases of buffers
+  // replaced by a resize can be told apart.
+  uint32_t first_buffer_id_;
+  // Buffer being drawn into, -1 until GetSurface() picks one.
+  int current_;
+  // Last presented buffer, -1 if none.
+  int last_presented_;
+  uint64_t present_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(OzoneWaylandCanvas);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_OZONE_WAYLAND_CANVAS_H_
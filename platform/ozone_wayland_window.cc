@@ -6,6 +6,8 @@
 
 #include <vector>
 #include "base/bind.h"
+#include "base/logging.h"
+#include "ozone/platform/cursor_factory_wayland.h"
 #include "ozone/platform/messages.h"
 #include "ozone/platform/ozone_gpu_platform_support_host.h"
 #include "ozone/platform/window_manager_wayland.h"
@@ -13,6 +15,7 @@
 #include "ui/events/ozone/events_ozone.h"
 #include "ui/events/platform/platform_event_source.h"
 #include "ui/gfx/screen.h"
+#include "ui/gfx/skia_util.h"
 #include "ui/platform_window/platform_window_delegate.h"
 
 namespace ui {
@@ -28,8 +31,8 @@ OzoneWaylandWindow::OzoneWaylandWindow(PlatformWindowDelegate* delegate,
       bounds_(bounds),
       parent_(0),
       state_(UNINITIALIZED),
-      region_(NULL),
-      cursor_type_(-1) {
+      region_sent_(false),
+      cursor_type_(CURSOR_NONE) {
   static int opaque_handle = 0;
   opaque_handle++;
   handle_ = opaque_handle;
@@ -39,8 +42,6 @@ OzoneWaylandWindow::OzoneWaylandWindow(PlatformWindowDelegate* delegate,
 OzoneWaylandWindow::~OzoneWaylandWindow() {
   sender_->RemoveChannelObserver(this);
   PlatformEventSource::GetInstance()->RemovePlatformEventDispatcher(this);
-  if (region_)
-    delete region_;
 }
 
 void OzoneWaylandWindow::InitPlatformWindow(
@@ -90,27 +91,15 @@ void OzoneWaylandWindow::SetTitle(const base::string16& title) {
 }
 
 void OzoneWaylandWindow::SetWindowShape(const SkPath& path) {
-  ResetRegion();
-  if (transparent_)
-    return;
-
-  region_ = new SkRegion();
   SkRegion clip_region;
   clip_region.setRect(0, 0, bounds_.width(), bounds_.height());
-  region_->setPath(path, clip_region);
-  AddRegion();
+  region_.setPath(path, clip_region);
+  UpdateRegion();
 }
 
 void OzoneWaylandWindow::SetOpacity(unsigned char opacity) {
-  if (opacity == 255) {
-    if (transparent_) {
-      AddRegion();
-      transparent_ = false;
-    }
-  } else if (!transparent_) {
-    ResetRegion();
-    transparent_ = true;
-  }
+  transparent_ = opacity != 255;
+  UpdateRegion();
 }
 
 void OzoneWaylandWindow::RequestDragData(const std::string& mime_type) {
@@ -130,6 +119,10 @@ void OzoneWaylandWindow::DragWillBeRejected(uint32_t serial) {
   sender_->Send(new WaylandDisplay_DragWillBeRejected(serial));
 }
 
+void OzoneWaylandWindow::RequestFrameTimingStats() {
+  sender_->Send(new WaylandDisplay_GetFrameTimingStats(handle_));
+}
+
 gfx::Rect OzoneWaylandWindow::GetBounds() {
   return bounds_;
 }
@@ -164,6 +157,9 @@ void OzoneWaylandWindow::Hide() {
 }
 
 void OzoneWaylandWindow::Close() {
+  if (VLOG_IS_ON(1))
+    RequestFrameTimingStats();
+
   if (type_ != ui::TOOLTIP)
     window_manager_->OnRootWindowClosed(this);
 }
@@ -210,6 +206,7 @@ void OzoneWaylandWindow::SetCursor(PlatformCursor cursor) {
   scoped_refptr<BitmapCursorOzone> bitmap =
       BitmapCursorFactoryOzone::GetBitmapCursor(cursor);
   bitmap_ = bitmap;
+  cursor_type_ = CursorFactoryWayland::GetCursorType(cursor);
   window_manager_->SetPlatformCursor(cursor);
   if (!sender_->IsConnected())
     return;
@@ -251,7 +248,8 @@ void OzoneWaylandWindow::OnChannelEstablished() {
   if (title_.length())
     sender_->Send(new WaylandDisplay_Title(handle_, title_));
 
-  AddRegion();
+  region_sent_ = false;
+  UpdateRegion();
   SetCursor();
 }
 
@@ -265,41 +263,47 @@ void OzoneWaylandWindow::SendWidgetState() {
   sender_->Send(new WaylandDisplay_State(handle_, state_));
 }
 
-void OzoneWaylandWindow::AddRegion() {
-  if (sender_->IsConnected() && region_ && !region_->isEmpty()) {
-     const SkIRect& rect = region_->getBounds();
-     sender_->Send(new WaylandDisplay_AddRegion(handle_,
-                                                rect.left(),
-                                                rect.top(),
-                                                rect.right(),
-                                                rect.bottom()));
-  }
-}
-
-void OzoneWaylandWindow::ResetRegion() {
-  if (region_) {
-    if (sender_->IsConnected() && !region_->isEmpty()) {
-      const SkIRect& rect = region_->getBounds();
-      sender_->Send(new WaylandDisplay_SubRegion(handle_,
-                                                 rect.left(),
-                                                 rect.top(),
-                                                 rect.right(),
-                                                 rect.bottom()));
-    }
+void OzoneWaylandWindow::UpdateRegion() {
+  if (!sender_->IsConnected())
+    return;
 
-    delete region_;
-    region_ = NULL;
+  // The shape covers everything the window paints, so it is the input region.
+  // Window contents are never transparent per pixel here, see
+  // DesktopWindowTreeHostOzone::ShouldWindowContentsBeTransparent(), so there
+  // is no translucent border to cut out of the shape: an opaque window is
+  // opaque wherever it paints. Translucency only comes from SetOpacity(),
+  // which applies to the whole window, so a translucent window has no opaque
+  // part at all and leaves the opaque region empty.
+  std::vector<gfx::Rect> input_region;
+  for (SkRegion::Iterator it(region_); !it.done(); it.next())
+    input_region.push_back(gfx::SkIRectToRect(it.rect()));
+
+  std::vector<gfx::Rect> opaque_region;
+  if (!transparent_)
+    opaque_region = input_region;
+
+  if (region_sent_ &&
+      opaque_region == sent_opaque_region_ &&
+      input_region == sent_input_region_) {
+    return;
   }
+
+  sender_->Send(new WaylandDisplay_SetRegion(handle_,
+                                             opaque_region,
+                                             input_region));
+  sent_opaque_region_.swap(opaque_region);
+  sent_input_region_.swap(input_region);
+  region_sent_ = true;
 }
 
 void OzoneWaylandWindow::SetCursor() {
-  if (bitmap_) {
-    sender_->Send(new WaylandDisplay_CursorSet(bitmap_->bitmaps(),
-                                               bitmap_->hotspot()));
-  } else {
-    sender_->Send(new WaylandDisplay_CursorSet(std::vector<SkBitmap>(),
-                                               gfx::Point()));
+  if (window_manager_->IsCursorThemed(cursor_type_)) {
+    sender_->Send(new WaylandDisplay_CursorSetType(cursor_type_));
+    return;
   }
+
+  sender_->Send(new WaylandDisplay_CursorSet(
+      window_manager_->GetCursorId(bitmap_.get())));
 }
 
 void OzoneWaylandWindow::ValidateBounds() {
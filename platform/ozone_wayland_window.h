@@ -6,6 +6,8 @@
 #define OZONE_PLATFORM_OZONE_WAYLAND_WINDOW_H_
 
 #include <string>
+#include <vector>
+
 #include "base/memory/ref_counted.h"
 #include "ozone/platform/window_constants.h"
 #include "third_party/skia/include/core/SkRegion.h"
@@ -35,6 +37,11 @@ class OzoneWaylandWindow : public PlatformWindow,
   unsigned GetHandle() const { return handle_; }
   PlatformWindowDelegate* GetDelegate() const { return delegate_; }
 
+  // Asks the GPU process for the frame timing statistics of the window, which
+  // WindowManagerWayland logs once they arrive. Done automatically when the
+  // window is closed with verbose logging enabled.
+  void RequestFrameTimingStats();
+
   // PlatformWindow:
   void InitPlatformWindow(PlatformWindowType type,
                           gfx::AcceleratedWidget parent_window) override;
@@ -72,8 +79,9 @@ class OzoneWaylandWindow : public PlatformWindow,
 
  private:
   void SendWidgetState();
-  void AddRegion();
-  void ResetRegion();
+  // Sends the opaque and input regions derived from |region_| and
+  // |transparent_| to the GPU process, unless they match the last ones sent.
+  void UpdateRegion();
   void SetCursor();
   void ValidateBounds();
   PlatformWindowDelegate* delegate_;   // Not owned.
@@ -85,8 +93,13 @@ class OzoneWaylandWindow : public PlatformWindow,
   unsigned parent_;
   ui::WidgetType type_;
   ui::WidgetState state_;
-  SkRegion* region_;
-  int cursor_type_;
+  // Window shape set by SetWindowShape, empty if the window is unshaped.
+  SkRegion region_;
+  std::vector<gfx::Rect> sent_opaque_region_;
+  std::vector<gfx::Rect> sent_input_region_;
+  bool region_sent_;
+  // Standard cursor the current cursor stands for, if any.
+  WaylandCursorType cursor_type_;
   base::string16 title_;
   // The current cursor bitmap (immutable).
   scoped_refptr<BitmapCursorOzone> bitmap_;
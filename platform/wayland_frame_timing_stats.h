@@ -0,0 +1,37 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_WAYLAND_FRAME_TIMING_STATS_H_
+#define OZONE_PLATFORM_WAYLAND_FRAME_TIMING_STATS_H_
+
+#include <stdint.h>
+
+namespace ui {
+
+// Presentation feedback of a window's surface, accumulated in the GPU process
+// since the surface was created and sent to the browser on request.
+struct WaylandFrameTimingStats {
+  // Swaps for which feedback was requested, and how they ended. Swaps still
+  // waiting for the compositor are in neither of the outcomes.
+  uint32_t frames_swapped = 0;
+  uint32_t frames_presented = 0;
+  uint32_t frames_discarded = 0;
+  // Presented frames which the compositor showed without copying them.
+  uint32_t frames_zero_copy = 0;
+  // Time from swap to presentation in microseconds. Only known if the
+  // compositor uses the clock of base::TimeTicks, |latency_samples| tells
+  // for how many frames.
+  uint32_t latency_samples = 0;
+  int64_t latency_sum_us = 0;
+  int64_t latency_max_us = 0;
+  // Sum of the absolute differences between the latencies of consecutive
+  // frames, the mean of which is the jitter.
+  int64_t jitter_sum_us = 0;
+  // Refresh interval reported with the last presented frame, 0 if unknown.
+  uint32_t refresh_ns = 0;
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_WAYLAND_FRAME_TIMING_STATS_H_
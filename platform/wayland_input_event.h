@@ -0,0 +1,61 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_WAYLAND_INPUT_EVENT_H_
+#define OZONE_PLATFORM_WAYLAND_INPUT_EVENT_H_
+
+#include <stdint.h>
+
+#include "ui/events/event_constants.h"
+
+namespace ui {
+
+// A pointer or touch event as seen by the Wayland poll thread in the GPU
+// process. Events are collected until the end of a protocol frame and sent to
+// the browser in one WaylandInput_EventBatch message.
+struct WaylandInputEvent {
+  enum Type {
+    MOTION = 0,
+    BUTTON = 1,
+    AXIS = 2,
+    POINTER_ENTER = 3,
+    POINTER_LEAVE = 4,
+    TOUCH = 5,
+    // Precise scrolling from touchpads and other continuous sources.
+    SCROLL = 6
+  };
+
+  Type type = MOTION;
+  // Window handle the event is targeted at. Not set for MOTION, AXIS and
+  // SCROLL.
+  unsigned handle = 0;
+  // BUTTON, TOUCH and SCROLL only.
+  EventType event_type = ET_UNKNOWN;
+  // BUTTON only.
+  EventFlags flags = EF_NONE;
+  float x = 0;
+  float y = 0;
+  // AXIS and SCROLL only. Wheel offsets for AXIS, pixels for ET_SCROLL and
+  // pixels per second for ET_SCROLL_FLING_START.
+  float x_offset = 0;
+  float y_offset = 0;
+  // TOUCH only.
+  int32_t touch_id = 0;
+  // Compositor timestamp in milliseconds, 0 if the protocol event has none.
+  uint32_t time_stamp = 0;
+  // The following are base::TimeTicks internal values. |event_time| is the
+  // compositor timestamp on the base::TimeTicks clock if the compositor uses
+  // the monotonic clock, |capture_time| otherwise. |capture_time| is when the
+  // poll thread queued the event and |send_time| when its batch was sent.
+  int64_t event_time = 0;
+  int64_t capture_time = 0;
+  int64_t send_time = 0;
+  // Shared memory ring only. Number of messages the GPU process had sent
+  // after announcing the ring when the event was written to it.
+  uint32_t sequence = 0;
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_WAYLAND_INPUT_EVENT_H_
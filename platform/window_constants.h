@@ -30,6 +30,45 @@ namespace ui {
     TOOLTIP = 4
   };
 
+  // Standard cursors the GPU process loads from the cursor theme.
+  enum WaylandCursorType {
+    CURSOR_NONE = 0,  // Not a standard cursor, hides the cursor if set.
+    CURSOR_POINTER = 1,
+    CURSOR_CROSS = 2,
+    CURSOR_HAND = 3,
+    CURSOR_IBEAM = 4,
+    CURSOR_WAIT = 5,
+    CURSOR_HELP = 6,
+    CURSOR_PROGRESS = 7,
+    CURSOR_MOVE = 8,
+    CURSOR_VERTICAL_TEXT = 9,
+    CURSOR_CELL = 10,
+    CURSOR_CONTEXT_MENU = 11,
+    CURSOR_ALIAS = 12,
+    CURSOR_COPY = 13,
+    CURSOR_NO_DROP = 14,
+    CURSOR_NOT_ALLOWED = 15,
+    CURSOR_ZOOM_IN = 16,
+    CURSOR_ZOOM_OUT = 17,
+    CURSOR_GRAB = 18,
+    CURSOR_GRABBING = 19,
+    CURSOR_NORTH_RESIZE = 20,
+    CURSOR_NORTH_EAST_RESIZE = 21,
+    CURSOR_EAST_RESIZE = 22,
+    CURSOR_SOUTH_EAST_RESIZE = 23,
+    CURSOR_SOUTH_RESIZE = 24,
+    CURSOR_SOUTH_WEST_RESIZE = 25,
+    CURSOR_WEST_RESIZE = 26,
+    CURSOR_NORTH_WEST_RESIZE = 27,
+    CURSOR_NORTH_SOUTH_RESIZE = 28,
+    CURSOR_EAST_WEST_RESIZE = 29,
+    CURSOR_NORTH_EAST_SOUTH_WEST_RESIZE = 30,
+    CURSOR_NORTH_WEST_SOUTH_EAST_RESIZE = 31,
+    CURSOR_COLUMN_RESIZE = 32,
+    CURSOR_ROW_RESIZE = 33,
+    CURSOR_TYPE_LAST = CURSOR_ROW_RESIZE
+  };
+
 }  // namespace ui
 
 #endif  // OZONE_UI_EVENTS_WINDOW_CONSTANTS_H_
@@ -8,20 +8,81 @@
 #include <string>
 
 #include "base/bind.h"
+#include "base/files/scoped_file.h"
+#include "base/message_loop/message_loop.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/posix/eintr_wrapper.h"
 #include "base/thread_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/platform/cursor_factory_wayland.h"
 #include "ozone/platform/desktop_platform_screen_delegate.h"
 #include "ozone/platform/messages.h"
 #include "ozone/platform/ozone_gpu_platform_support_host.h"
+#include "ozone/platform/ozone_wayland_canvas.h"
 #include "ozone/platform/ozone_wayland_window.h"
+#include "ozone/wayland/input_ring_buffer.h"
 #include "ozone/wayland/ozone_wayland_screen.h"
 #include "ui/aura/window.h"
+#include "ui/base/cursor/ozone/bitmap_cursor_factory_ozone.h"
 #include "ui/events/event_utils.h"
 #include "ui/events/ozone/layout/keyboard_layout_engine_manager.h"
 #include "ui/events/platform/platform_event_source.h"
+#include "ui/gfx/geometry/safe_integer_conversions.h"
 #include "ui/platform_window/platform_window_delegate.h"
 
 namespace ui {
 
+// Lives on the browser IO thread. Every time the GPU process rings the
+// doorbell of the input ring it asks the UI thread to drain the ring.
+class WindowManagerWayland::InputRingDoorbellWatcher
+    : public base::MessagePumpLibevent::Watcher {
+ public:
+  InputRingDoorbellWatcher(
+      int doorbell_fd,
+      scoped_refptr<base::SingleThreadTaskRunner> ui_task_runner,
+      const base::Closure& drain_callback)
+      : doorbell_fd_(doorbell_fd),
+        ui_task_runner_(ui_task_runner),
+        drain_callback_(drain_callback) {
+  }
+
+  ~InputRingDoorbellWatcher() override {
+  }
+
+  void StartWatching() {
+    base::MessageLoopForIO::current()->WatchFileDescriptor(
+        doorbell_fd_.get(), true, base::MessageLoopForIO::WATCH_READ,
+        &controller_, this);
+  }
+
+  // base::MessagePumpLibevent::Watcher:
+  void OnFileCanReadWithoutBlocking(int fd) override {
+    uint64_t value;
+    HANDLE_EINTR(read(fd, &value, sizeof(value)));
+    ui_task_runner_->PostTask(FROM_HERE, drain_callback_);
+  }
+
+  void OnFileCanWriteWithoutBlocking(int fd) override {
+    NOTREACHED();
+  }
+
+ private:
+  base::ScopedFD doorbell_fd_;
+  base::MessagePumpLibevent::FileDescriptorWatcher controller_;
+  scoped_refptr<base::SingleThreadTaskRunner> ui_task_runner_;
+  base::Closure drain_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(InputRingDoorbellWatcher);
+};
+
+WindowManagerWayland::QueuedInput::QueuedInput()
+    : type(TASK),
+      transport(INPUT_TRANSPORT_IPC) {
+}
+
+WindowManagerWayland::QueuedInput::~QueuedInput() {
+}
+
 WindowManagerWayland::WindowManagerWayland(OzoneGpuPlatformSupportHost* proxy)
     : open_windows_(NULL),
       active_window_(NULL),
@@ -31,11 +92,19 @@ WindowManagerWayland::WindowManagerWayland(OzoneGpuPlatformSupportHost* proxy)
                 base::Bind(&WindowManagerWayland::PostUiEvent,
                            base::Unretained(this))),
       platform_screen_(NULL),
+      platform_cursor_(NULL),
+      next_cursor_id_(1),
+      themed_cursor_types_(0),
+      doorbell_watcher_(NULL),
+      ring_message_count_(0),
+      input_queue_drain_scheduled_(false),
+      coalesced_event_count_(0),
       weak_ptr_factory_(this) {
   proxy_->RegisterHandler(this);
 }
 
 WindowManagerWayland::~WindowManagerWayland() {
+  ResetInputRing();
 }
 
 void WindowManagerWayland::OnRootWindowCreated(
@@ -70,6 +139,21 @@ void WindowManagerWayland::OnRootWindowClosed(
   OnActivationChanged(open_windows().front()->GetHandle(), true);
 }
 
+scoped_ptr<SurfaceOzoneCanvas> WindowManagerWayland::CreateCanvas(
+    gfx::AcceleratedWidget widget) {
+  return make_scoped_ptr<SurfaceOzoneCanvas>(
+      new OzoneWaylandCanvas(widget, proxy_, this));
+}
+
+void WindowManagerWayland::OnCanvasCreated(unsigned handle,
+                                           OzoneWaylandCanvas* canvas) {
+  canvases_[handle] = canvas;
+}
+
+void WindowManagerWayland::OnCanvasDestroyed(unsigned handle) {
+  canvases_.erase(handle);
+}
+
 void WindowManagerWayland::Restore(OzoneWaylandWindow* window) {
   active_window_ = window;
   event_grabber_  = window->GetHandle();
@@ -89,6 +173,44 @@ void WindowManagerWayland::SetPlatformCursor(PlatformCursor cursor) {
   platform_cursor_ = cursor;
 }
 
+uint32_t WindowManagerWayland::GetCursorId(BitmapCursorOzone* cursor) {
+  EvictUnusedCursors();
+  if (!cursor)
+    return 0;
+
+  std::pair<scoped_refptr<BitmapCursorOzone>, uint32_t>& registered =
+      registered_cursors_[cursor];
+  if (!registered.first) {
+    registered.first = cursor;
+    registered.second = next_cursor_id_++;
+    proxy_->Send(new WaylandDisplay_CursorRegister(registered.second,
+                                                   cursor->bitmaps(),
+                                                   cursor->hotspot(),
+                                                   cursor->frame_delay_ms()));
+  }
+
+  return registered.second;
+}
+
+bool WindowManagerWayland::IsCursorThemed(WaylandCursorType type) const {
+  return type != CURSOR_NONE && (themed_cursor_types_ >> type) & 1;
+}
+
+void WindowManagerWayland::EvictUnusedCursors() {
+  // Windows hold a reference to the cursor they show and the cursor factory
+  // one to every cursor that is still in use.
+  for (auto it = registered_cursors_.begin();
+       it != registered_cursors_.end();) {
+    if (!it->second.first->HasOneRef()) {
+      ++it;
+      continue;
+    }
+
+    proxy_->Send(new WaylandDisplay_CursorEvict(it->second.second));
+    registered_cursors_.erase(it++);
+  }
+}
+
 bool WindowManagerWayland::HasWindowsOpen() const {
   return open_windows_ ? !open_windows_->empty() : false;
 }
@@ -234,12 +356,35 @@ void WindowManagerWayland::OnWindowActivated(unsigned windowhandle) {
 void WindowManagerWayland::OnChannelEstablished(
   int host_id, scoped_refptr<base::SingleThreadTaskRunner> send_runner,
       const base::Callback<void(IPC::Message*)>& send_callback) {
+  io_task_runner_ = send_runner;
 }
 
 void WindowManagerWayland::OnChannelDestroyed(int host_id) {
+  ResetInputRing();
+  // The cursors go away with the GPU process, they are registered again when
+  // the windows set them on the new channel.
+  registered_cursors_.clear();
+  themed_cursor_types_ = 0;
 }
 
 bool WindowManagerWayland::OnMessageReceived(const IPC::Message& message) {
+  // Counted like WaylandDisplay counts the messages it sends. Events written
+  // to the ring before this message was sent go first, the ones written
+  // after it only once it has been handled.
+  bool from_display = IPC_MESSAGE_ID_CLASS(message.type()) == LastIPCMsgStart;
+  if (from_display) {
+    DrainInputRing();
+    ring_message_count_++;
+  }
+
+  bool handled = OnDisplayMessageReceived(message);
+  if (from_display)
+    DrainInputRing();
+  return handled;
+}
+
+bool WindowManagerWayland::OnDisplayMessageReceived(
+    const IPC::Message& message) {
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(WindowManagerWayland, message)
   IPC_MESSAGE_HANDLER(WaylandInput_CloseWidget, CloseWidget)
@@ -247,12 +392,11 @@ bool WindowManagerWayland::OnMessageReceived(const IPC::Message& message) {
   IPC_MESSAGE_HANDLER(WaylandWindow_Activated, WindowActivated)
   IPC_MESSAGE_HANDLER(WaylandWindow_DeActivated, WindowDeActivated)
   IPC_MESSAGE_HANDLER(WaylandWindow_Unminimized, WindowUnminimized)
-  IPC_MESSAGE_HANDLER(WaylandInput_MotionNotify, MotionNotify)
-  IPC_MESSAGE_HANDLER(WaylandInput_ButtonNotify, ButtonNotify)
-  IPC_MESSAGE_HANDLER(WaylandInput_TouchNotify, TouchNotify)
-  IPC_MESSAGE_HANDLER(WaylandInput_AxisNotify, AxisNotify)
-  IPC_MESSAGE_HANDLER(WaylandInput_PointerEnter, PointerEnter)
-  IPC_MESSAGE_HANDLER(WaylandInput_PointerLeave, PointerLeave)
+  IPC_MESSAGE_HANDLER(WaylandWindow_FrameTimingStats, FrameTimingStats)
+  IPC_MESSAGE_HANDLER(WaylandWindow_CanvasBufferReleased, CanvasBufferReleased)
+  IPC_MESSAGE_HANDLER(WaylandInput_CursorTheme, CursorTheme)
+  IPC_MESSAGE_HANDLER(WaylandInput_EventBatch, EventBatch)
+  IPC_MESSAGE_HANDLER(WaylandInput_InputRingCreated, InputRingCreated)
   IPC_MESSAGE_HANDLER(WaylandInput_KeyNotify, KeyNotify)
   IPC_MESSAGE_HANDLER(WaylandInput_VirtualKeyNotify, VirtualKeyNotify)
   IPC_MESSAGE_HANDLER(WaylandInput_OutputSize, OutputSizeChanged)
@@ -268,50 +412,51 @@ bool WindowManagerWayland::OnMessageReceived(const IPC::Message& message) {
   return handled;
 }
 
-void WindowManagerWayland::MotionNotify(float x, float y) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyMotion,
-          weak_ptr_factory_.GetWeakPtr(), x, y));
+void WindowManagerWayland::CursorTheme(uint64_t themed_types) {
+  themed_cursor_types_ = themed_types;
+  // Windows set their cursor on the new channel before the GPU process told
+  // which cursors its theme has, switch to the themed one if there is one.
+  WaylandCursorType type =
+      CursorFactoryWayland::GetCursorType(platform_cursor_);
+  if (IsCursorThemed(type))
+    proxy_->Send(new WaylandDisplay_CursorSetType(type));
 }
 
-void WindowManagerWayland::ButtonNotify(unsigned handle,
-                                        EventType type,
-                                        EventFlags flags,
-                                        float x,
-                                        float y) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyButtonPress,
-          weak_ptr_factory_.GetWeakPtr(), handle, type, flags, x, y));
+void WindowManagerWayland::EventBatch(
+    const std::vector<WaylandInputEvent>& events) {
+  QueueEventBatch(events, INPUT_TRANSPORT_IPC, base::TimeTicks::Now());
 }
 
-void WindowManagerWayland::AxisNotify(float x,
-                                      float y,
-                                      int xoffset,
-                                      int yoffset) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyAxis,
-          weak_ptr_factory_.GetWeakPtr(), x, y, xoffset, yoffset));
-}
+void WindowManagerWayland::InputRingCreated(base::SharedMemoryHandle ring,
+                                            uint32_t size,
+                                            base::FileDescriptor doorbell) {
+  ResetInputRing();
+  ring_message_count_ = 0;
+  base::ScopedFD doorbell_fd(doorbell.fd);
+  if (!io_task_runner_) {
+    close(ring.fd);
+    return;
+  }
 
-void WindowManagerWayland::PointerEnter(unsigned handle,
-                                        float x,
-                                        float y) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyPointerEnter,
-          weak_ptr_factory_.GetWeakPtr(), handle, x, y));
-}
+  scoped_ptr<ozonewayland::WaylandInputRingBuffer> input_ring(
+      new ozonewayland::WaylandInputRingBuffer());
+  if (!input_ring->Map(ring, size, base::FileDescriptor(dup(doorbell_fd.get()),
+                                                        true))) {
+    return;
+  }
 
-void WindowManagerWayland::PointerLeave(unsigned handle,
-                                        float x,
-                                        float y) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
+  input_ring_ = input_ring.Pass();
+  doorbell_watcher_ = new InputRingDoorbellWatcher(
+      doorbell_fd.release(),
+      base::ThreadTaskRunnerHandle::Get(),
+      base::Bind(&WindowManagerWayland::DrainInputRing,
+                 weak_ptr_factory_.GetWeakPtr()));
+  io_task_runner_->PostTask(
       FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyPointerLeave,
-          weak_ptr_factory_.GetWeakPtr(), handle, x, y));
+      base::Bind(&InputRingDoorbellWatcher::StartWatching,
+                 base::Unretained(doorbell_watcher_)));
+  // The GPU process may have written events before we started to watch.
+  DrainInputRing();
 }
 
 void WindowManagerWayland::KeyNotify(EventType type,
@@ -323,78 +468,82 @@ void WindowManagerWayland::KeyNotify(EventType type,
 void WindowManagerWayland::VirtualKeyNotify(EventType type,
                                             uint32_t key,
                                             int device_id) {
-  keyboard_.OnKeyChange(key,
-                        type != ET_KEY_RELEASED,
-                        false,
-                        EventTimeForNow(),
-                        device_id);
-}
-
-void WindowManagerWayland::TouchNotify(EventType type,
-                                       float x,
-                                       float y,
-                                       int32_t touch_id,
-                                       uint32_t time_stamp) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyTouchEvent,
-          weak_ptr_factory_.GetWeakPtr(), type, x, y, touch_id, time_stamp));
+  QueueTask(base::Bind(&WindowManagerWayland::NotifyKeyChange,
+                       weak_ptr_factory_.GetWeakPtr(), type, key, device_id));
 }
 
 void WindowManagerWayland::CloseWidget(unsigned handle) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::OnWindowClose,
+  QueueTask(base::Bind(&WindowManagerWayland::OnWindowClose,
           weak_ptr_factory_.GetWeakPtr(), handle));
 }
 
 void WindowManagerWayland::OutputSizeChanged(unsigned width,
                                              unsigned height) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyOutputSizeChanged,
+  QueueTask(base::Bind(&WindowManagerWayland::NotifyOutputSizeChanged,
           weak_ptr_factory_.GetWeakPtr(), width, height));
 }
 
 void WindowManagerWayland::WindowResized(unsigned handle,
                                          unsigned width,
                                          unsigned height) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::OnWindowResized,
+  QueueTask(base::Bind(&WindowManagerWayland::OnWindowResized,
           weak_ptr_factory_.GetWeakPtr(), handle, width, height));
 }
 
 void WindowManagerWayland::WindowUnminimized(unsigned handle) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::OnWindowUnminimized,
+  QueueTask(base::Bind(&WindowManagerWayland::OnWindowUnminimized,
           weak_ptr_factory_.GetWeakPtr(), handle));
 }
 
 void WindowManagerWayland::WindowDeActivated(unsigned windowhandle) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::OnWindowDeActivated,
+  QueueTask(base::Bind(&WindowManagerWayland::OnWindowDeActivated,
           weak_ptr_factory_.GetWeakPtr(), windowhandle));
 }
 
 void WindowManagerWayland::WindowActivated(unsigned windowhandle) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::OnWindowActivated,
+  QueueTask(base::Bind(&WindowManagerWayland::OnWindowActivated,
           weak_ptr_factory_.GetWeakPtr(), windowhandle));
 }
 
+void WindowManagerWayland::CanvasBufferReleased(unsigned windowhandle,
+                                                uint32_t buffer_id) {
+  std::map<unsigned, OzoneWaylandCanvas*>::const_iterator it =
+      canvases_.find(windowhandle);
+  if (it != canvases_.end())
+    it->second->OnBufferReleased(buffer_id);
+}
+
+void WindowManagerWayland::FrameTimingStats(
+    unsigned windowhandle,
+    const WaylandFrameTimingStats& stats) {
+  uint32_t completed = stats.frames_presented + stats.frames_discarded;
+  double dropped_rate =
+      completed ? static_cast<double>(stats.frames_discarded) / completed : 0;
+  int64_t mean_latency_us = stats.latency_samples ?
+      stats.latency_sum_us / stats.latency_samples : 0;
+  int64_t jitter_us = stats.latency_samples > 1 ?
+      stats.jitter_sum_us / (stats.latency_samples - 1) : 0;
+  TRACE_EVENT_INSTANT2("ozone", "WaylandFrameTimingStats",
+                       TRACE_EVENT_SCOPE_THREAD,
+                       "handle", windowhandle,
+                       "frames_presented", stats.frames_presented);
+  VLOG(1) << "Frame timing of window " << windowhandle << ": "
+          << stats.frames_swapped << " swapped, "
+          << stats.frames_presented << " presented ("
+          << stats.frames_zero_copy << " zero-copy), "
+          << stats.frames_discarded << " discarded, dropped frame rate "
+          << dropped_rate << ", swap to present " << mean_latency_us
+          << " us (max " << stats.latency_max_us << " us), jitter "
+          << jitter_us << " us, refresh " << stats.refresh_ns << " ns";
+}
+
 void WindowManagerWayland::DragEnter(
     unsigned windowhandle,
     float x,
     float y,
     const std::vector<std::string>& mime_types,
     uint32_t serial) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyDragEnter,
+  QueueTask(base::Bind(&WindowManagerWayland::NotifyDragEnter,
           weak_ptr_factory_.GetWeakPtr(),
           windowhandle, x, y, mime_types, serial));
 }
@@ -403,16 +552,12 @@ void WindowManagerWayland::DragData(unsigned windowhandle,
                                     base::FileDescriptor pipefd) {
   // TODO(mcatanzaro): pipefd will be leaked if the WindowManagerWayland is
   // destroyed before NotifyDragData is called.
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyDragData,
+  QueueTask(base::Bind(&WindowManagerWayland::NotifyDragData,
           weak_ptr_factory_.GetWeakPtr(), windowhandle, pipefd));
 }
 
 void WindowManagerWayland::DragLeave(unsigned windowhandle) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyDragLeave,
+  QueueTask(base::Bind(&WindowManagerWayland::NotifyDragLeave,
           weak_ptr_factory_.GetWeakPtr(), windowhandle));
 }
 
@@ -420,16 +565,17 @@ void WindowManagerWayland::DragMotion(unsigned windowhandle,
                                       float x,
                                       float y,
                                       uint32_t time) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyDragMotion,
-          weak_ptr_factory_.GetWeakPtr(), windowhandle, x, y, time));
+  QueuedInput motion;
+  motion.type = QueuedInput::DRAG_MOTION;
+  motion.event.handle = windowhandle;
+  motion.event.x = x;
+  motion.event.y = y;
+  motion.event.time_stamp = time;
+  QueueMotion(motion);
 }
 
 void WindowManagerWayland::DragDrop(unsigned windowhandle) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyDragDrop,
+  QueueTask(base::Bind(&WindowManagerWayland::NotifyDragDrop,
           weak_ptr_factory_.GetWeakPtr(), windowhandle));
 }
 
@@ -464,14 +610,263 @@ void WindowManagerWayland::DispatchUiEventTask(scoped_ptr<Event> event) {
 void WindowManagerWayland::OnDispatcherListChanged() {
 }
 
+void WindowManagerWayland::DrainInputRing() {
+  if (!input_ring_)
+    return;
+
+  std::vector<WaylandInputEvent> events;
+  input_ring_->Read(ring_message_count_, &events);
+  if (events.empty())
+    return;
+
+  QueueEventBatch(events, INPUT_TRANSPORT_SHARED_MEMORY,
+                  base::TimeTicks::Now());
+}
+
+void WindowManagerWayland::ResetInputRing() {
+  if (doorbell_watcher_) {
+    io_task_runner_->DeleteSoon(FROM_HERE, doorbell_watcher_);
+    doorbell_watcher_ = NULL;
+  }
+
+  input_ring_.reset();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
+void WindowManagerWayland::QueueTask(const base::Closure& task) {
+  QueuedInput input;
+  input.type = QueuedInput::TASK;
+  input.task = task;
+  input_queue_.push_back(input);
+  ScheduleInputQueueDrain();
+}
+
+void WindowManagerWayland::QueueMotion(const QueuedInput& motion) {
+  // Keep a bounded number of older samples per merged event.
+  const size_t kMaxMotionHistory = 32;
+  if (!input_queue_.empty()) {
+    QueuedInput& last = input_queue_.back();
+    if (last.type == motion.type &&
+        last.event.handle == motion.event.handle) {
+      if (last.history.size() == kMaxMotionHistory)
+        last.history.erase(last.history.begin());
+      last.history.push_back(last.event);
+      last.event = motion.event;
+      last.transport = motion.transport;
+      last.received_time = motion.received_time;
+      ++coalesced_event_count_;
+      TRACE_COUNTER1("ozone", "WaylandCoalescedMotionEvents",
+                     coalesced_event_count_);
+      return;
+    }
+  }
+
+  input_queue_.push_back(motion);
+  ScheduleInputQueueDrain();
+}
+
+void WindowManagerWayland::ScheduleInputQueueDrain() {
+  if (input_queue_drain_scheduled_)
+    return;
+
+  input_queue_drain_scheduled_ = true;
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE,
+      base::Bind(&WindowManagerWayland::DispatchInputQueue,
+          weak_ptr_factory_.GetWeakPtr()));
+}
+
+void WindowManagerWayland::DispatchInputQueue() {
+  TRACE_EVENT1("ozone", "WindowManagerWayland::DispatchInputQueue",
+               "size", input_queue_.size());
+  // Anything queued from here on, e.g. by a nested message loop entered
+  // during dispatch, needs a new task.
+  input_queue_drain_scheduled_ = false;
+  base::WeakPtr<WindowManagerWayland> weak_this =
+      weak_ptr_factory_.GetWeakPtr();
+  // Entries are popped one at a time so that a nested drain continues in
+  // order where this one stopped.
+  while (weak_this && !input_queue_.empty()) {
+    QueuedInput input = input_queue_.front();
+    input_queue_.pop_front();
+    switch (input.type) {
+      case QueuedInput::MOTION:
+        coalesced_motion_history_.swap(input.history);
+        NotifyInputEvent(input.event, input.transport, input.received_time);
+        if (weak_this)
+          coalesced_motion_history_.clear();
+        break;
+      case QueuedInput::DRAG_MOTION:
+        NotifyDragMotion(input.event.handle,
+                         input.event.x,
+                         input.event.y,
+                         input.event.time_stamp);
+        break;
+      case QueuedInput::TASK:
+        input.task.Run();
+        break;
+      default:
+        NOTREACHED();
+        break;
+    }
+  }
+}
+
+void WindowManagerWayland::QueueEventBatch(
+    const std::vector<WaylandInputEvent>& events,
+    InputTransport transport,
+    base::TimeTicks received_time) {
+  TRACE_EVENT2("ozone", "WindowManagerWayland::QueueEventBatch",
+               "events", events.size(),
+               "shared_memory", transport == INPUT_TRANSPORT_SHARED_MEMORY);
+  for (const WaylandInputEvent& event : events) {
+    if (event.type == WaylandInputEvent::MOTION) {
+      QueuedInput motion;
+      motion.type = QueuedInput::MOTION;
+      motion.event = event;
+      motion.transport = transport;
+      motion.received_time = received_time;
+      QueueMotion(motion);
+    } else {
+      QueueTask(base::Bind(&WindowManagerWayland::NotifyInputEvent,
+                           weak_ptr_factory_.GetWeakPtr(), event, transport,
+                           received_time));
+    }
+  }
+}
+
+void WindowManagerWayland::NotifyInputEvent(const WaylandInputEvent& event,
+                                            InputTransport transport,
+                                            base::TimeTicks received_time) {
+  // Compositor time converted to base::TimeTicks by the GPU process, this is
+  // what velocity and gesture detection should see rather than the time the
+  // event happens to be dispatched here.
+  base::TimeDelta time_stamp =
+      base::TimeTicks::FromInternalValue(event.event_time) - base::TimeTicks();
+  switch (event.type) {
+    case WaylandInputEvent::MOTION:
+      NotifyMotion(event.x, event.y, time_stamp);
+      break;
+    case WaylandInputEvent::BUTTON:
+      NotifyButtonPress(event.handle,
+                        event.event_type,
+                        event.flags,
+                        event.x,
+                        event.y,
+                        time_stamp);
+      break;
+    case WaylandInputEvent::AXIS:
+      NotifyAxis(event.x,
+                 event.y,
+                 event.x_offset,
+                 event.y_offset,
+                 time_stamp);
+      break;
+    case WaylandInputEvent::SCROLL:
+      NotifyScroll(event.event_type,
+                   event.x,
+                   event.y,
+                   event.x_offset,
+                   event.y_offset,
+                   time_stamp);
+      break;
+    case WaylandInputEvent::POINTER_ENTER:
+      NotifyPointerEnter(event.handle, event.x, event.y, time_stamp);
+      break;
+    case WaylandInputEvent::POINTER_LEAVE:
+      NotifyPointerLeave(event.handle, event.x, event.y, time_stamp);
+      break;
+    case WaylandInputEvent::TOUCH:
+      NotifyTouchEvent(event.event_type,
+                       event.x,
+                       event.y,
+                       event.touch_id,
+                       time_stamp);
+      break;
+    default:
+      NOTREACHED();
+      break;
+  }
+
+  RecordInputLatency(event, transport, received_time);
+}
+
+void WindowManagerWayland::NotifyKeyChange(EventType type,
+                                           uint32_t key,
+                                           int device_id) {
+  keyboard_.OnKeyChange(key,
+                        type != ET_KEY_RELEASED,
+                        false,
+                        EventTimeForNow(),
+                        device_id);
+}
+
+void WindowManagerWayland::RecordInputLatency(const WaylandInputEvent& event,
+                                              InputTransport transport,
+                                              base::TimeTicks received_time) {
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeTicks event_time =
+      base::TimeTicks::FromInternalValue(event.event_time);
+  base::TimeTicks capture_time =
+      base::TimeTicks::FromInternalValue(event.capture_time);
+  base::TimeTicks send_time =
+      base::TimeTicks::FromInternalValue(event.send_time);
+
+  // Compositor to poll thread. Only known if the compositor timestamp could
+  // be mapped to our clock, otherwise |event_time| is |capture_time|.
+  base::TimeDelta poll_thread = capture_time - event_time;
+  // Waiting for the end of the protocol frame on the GPU side.
+  base::TimeDelta gpu_send = send_time - capture_time;
+  // From the GPU side sending the batch until the UI thread picked it up from
+  // the transport. This includes the hop through the browser IO thread, which
+  // is not timed separately.
+  base::TimeDelta delivery = received_time - send_time;
+  // Waiting in the UI task queue and dispatch itself.
+  base::TimeDelta ui_dispatch = now - received_time;
+
+  if (event_time != capture_time) {
+    UMA_HISTOGRAM_CUSTOM_COUNTS("Ozone.Wayland.InputLatency.PollThread",
+                                poll_thread.InMicroseconds(), 1, 1000000, 50);
+  }
+  UMA_HISTOGRAM_CUSTOM_COUNTS("Ozone.Wayland.InputLatency.GpuSend",
+                              gpu_send.InMicroseconds(), 1, 1000000, 50);
+  UMA_HISTOGRAM_CUSTOM_COUNTS("Ozone.Wayland.InputLatency.Delivery",
+                              delivery.InMicroseconds(), 1, 1000000, 50);
+  UMA_HISTOGRAM_CUSTOM_COUNTS("Ozone.Wayland.InputLatency.UiDispatch",
+                              ui_dispatch.InMicroseconds(), 1, 1000000, 50);
+  UMA_HISTOGRAM_CUSTOM_COUNTS("Ozone.Wayland.InputLatency.Total",
+                              (now - event_time).InMicroseconds(),
+                              1, 1000000, 50);
+
+  // Time from queueing on the GPU side until dispatch here, recorded per
+  // transport so that IPC and the shared memory ring can be compared.
+  base::TimeDelta transport_latency = now - capture_time;
+  if (transport == INPUT_TRANSPORT_SHARED_MEMORY) {
+    UMA_HISTOGRAM_CUSTOM_COUNTS(
+        "Ozone.Wayland.InputTransportLatency.SharedMemory",
+        transport_latency.InMicroseconds(), 1, 1000000, 50);
+  } else {
+    UMA_HISTOGRAM_CUSTOM_COUNTS(
+        "Ozone.Wayland.InputTransportLatency.IPC",
+        transport_latency.InMicroseconds(), 1, 1000000, 50);
+  }
+
+  TRACE_COUNTER2("ozone", "WaylandInputLatencyGpu",
+                 "poll_thread_us", poll_thread.InMicroseconds(),
+                 "gpu_send_us", gpu_send.InMicroseconds());
+  TRACE_COUNTER2("ozone", "WaylandInputLatencyBrowser",
+                 "delivery_us", delivery.InMicroseconds(),
+                 "ui_dispatch_us", ui_dispatch.InMicroseconds());
+}
+
 void WindowManagerWayland::NotifyMotion(float x,
-                                        float y) {
+                                        float y,
+                                        base::TimeDelta time_stamp) {
   gfx::Point position(x, y);
   MouseEvent mouseev(ET_MOUSE_MOVED,
                          position,
                          position,
-                         EventTimeForNow(),
+                         time_stamp,
                          0,
                          0);
   DispatchEvent(&mouseev);
@@ -481,12 +876,13 @@ void WindowManagerWayland::NotifyButtonPress(unsigned handle,
                                              EventType type,
                                              EventFlags flags,
                                              float x,
-                                             float y) {
+                                             float y,
+                                             base::TimeDelta time_stamp) {
   gfx::Point position(x, y);
   MouseEvent mouseev(type,
                          position,
                          position,
-                         EventTimeForNow(),
+                         time_stamp,
                          flags,
                          flags);
 
@@ -498,31 +894,56 @@ void WindowManagerWayland::NotifyButtonPress(unsigned handle,
 
 void WindowManagerWayland::NotifyAxis(float x,
                                          float y,
-                                         int xoffset,
-                                         int yoffset) {
+                                         float xoffset,
+                                         float yoffset,
+                                         base::TimeDelta time_stamp) {
   gfx::Point position(x, y);
   MouseEvent mouseev(ET_MOUSEWHEEL,
                          position,
                          position,
-                         EventTimeForNow(),
+                         time_stamp,
                          0,
                          0);
 
-  MouseWheelEvent wheelev(mouseev, xoffset, yoffset);
+  MouseWheelEvent wheelev(mouseev,
+                          gfx::ToRoundedInt(xoffset),
+                          gfx::ToRoundedInt(yoffset));
 
   DispatchEvent(&wheelev);
 }
 
+void WindowManagerWayland::NotifyScroll(EventType type,
+                                        float x,
+                                        float y,
+                                        float xoffset,
+                                        float yoffset,
+                                        base::TimeDelta time_stamp) {
+  gfx::Point position(x, y);
+  // Touchpads scroll with two fingers.
+  ScrollEvent scrollev(type,
+                       position,
+                       time_stamp,
+                       0,
+                       xoffset,
+                       yoffset,
+                       xoffset,
+                       yoffset,
+                       2);
+
+  DispatchEvent(&scrollev);
+}
+
 void WindowManagerWayland::NotifyPointerEnter(unsigned handle,
                                                  float x,
-                                                 float y) {
+                                                 float y,
+                                                 base::TimeDelta time_stamp) {
   OnWindowEnter(handle);
 
   gfx::Point position(x, y);
   MouseEvent mouseev(ET_MOUSE_ENTERED,
                          position,
                          position,
-                         EventTimeForNow(),
+                         time_stamp,
                          0,
                          0);
 
@@ -531,14 +952,15 @@ void WindowManagerWayland::NotifyPointerEnter(unsigned handle,
 
 void WindowManagerWayland::NotifyPointerLeave(unsigned handle,
                                               float x,
-                                              float y) {
+                                              float y,
+                                              base::TimeDelta time_stamp) {
   OnWindowLeave(handle);
 
   gfx::Point position(x, y);
   MouseEvent mouseev(ET_MOUSE_EXITED,
                          position,
                          position,
-                         EventTimeForNow(),
+                         time_stamp,
                          0,
                          0);
 
@@ -549,10 +971,9 @@ void WindowManagerWayland::NotifyTouchEvent(EventType type,
                                             float x,
                                             float y,
                                             int32_t touch_id,
-                                            uint32_t time_stamp) {
+                                            base::TimeDelta time_stamp) {
   gfx::Point position(x, y);
-  base::TimeDelta time_delta = base::TimeDelta::FromMilliseconds(time_stamp);
-  TouchEvent touchev(type, position, touch_id, time_delta);
+  TouchEvent touchev(type, position, touch_id, time_stamp);
   DispatchEvent(&touchev);
 }
 
@@ -5,13 +5,18 @@
 #ifndef OZONE_IMPL_PLATFORM_WINDOW_MANAGER_OZONE_H_
 #define OZONE_IMPL_PLATFORM_WINDOW_MANAGER_OZONE_H_
 
+#include <deque>
 #include <list>
+#include <map>
 #include <string>
 #include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "ozone/platform/wayland_frame_timing_stats.h"
+#include "ozone/platform/wayland_input_event.h"
+#include "ozone/platform/window_constants.h"
 #include "ui/base/cursor/cursor.h"
 #include "ui/events/event.h"
 #include "ui/events/event_source.h"
@@ -21,14 +26,18 @@
 #include "ui/events/platform/platform_event_source.h"
 #include "ui/gfx/native_widget_types.h"
 #include "ui/ozone/public/gpu_platform_support_host.h"
+#include "ui/ozone/public/surface_ozone_canvas.h"
 
 namespace ozonewayland {
 class OzoneWaylandScreen;
+class WaylandInputRingBuffer;
 }
 
 namespace ui {
 
+class BitmapCursorOzone;
 class OzoneGpuPlatformSupportHost;
+class OzoneWaylandCanvas;
 class OzoneWaylandWindow;
 
 // A static class used by OzoneWaylandWindow for basic window management.
@@ -45,8 +54,18 @@ class WindowManagerWayland
 
   void OnPlatformScreenCreated(ozonewayland::OzoneWaylandScreen* screen);
 
+  // Creates the software rendered surface of |widget|.
+  scoped_ptr<SurfaceOzoneCanvas> CreateCanvas(gfx::AcceleratedWidget widget);
+  void OnCanvasCreated(unsigned handle, OzoneWaylandCanvas* canvas);
+  void OnCanvasDestroyed(unsigned handle);
+
   PlatformCursor GetPlatformCursor();
   void SetPlatformCursor(PlatformCursor cursor);
+  // Returns the id the GPU process knows |cursor| by, registering its bitmaps
+  // first if they weren't sent yet. 0 stands for no cursor.
+  uint32_t GetCursorId(BitmapCursorOzone* cursor);
+  // Whether the GPU process shows |type| from the cursor theme.
+  bool IsCursorThemed(WaylandCursorType type) const;
 
   OzoneWaylandWindow* GetWindow(unsigned handle);
   bool HasWindowsOpen() const;
@@ -63,6 +82,15 @@ class WindowManagerWayland
   // Gets the current widget recipient of mouse events.
   gfx::AcceleratedWidget event_grabber() const { return event_grabber_; }
 
+  // Older motion samples which were merged into the mouse move event being
+  // dispatched, oldest first. Only valid during dispatch of that event, can be
+  // used for prediction.
+  const std::vector<WaylandInputEvent>& coalesced_motion_history() const {
+    return coalesced_motion_history_;
+  }
+  // Number of motion and drag motion events merged into a later sample.
+  uint64_t coalesced_event_count() const { return coalesced_event_count_; }
+
  private:
   void OnActivationChanged(unsigned windowhandle, bool active);
   std::list<OzoneWaylandWindow*>& open_windows();
@@ -83,27 +111,18 @@ class WindowManagerWayland
       const base::Callback<void(IPC::Message*)>& send_callback) override;
   void OnChannelDestroyed(int host_id) override;
   bool OnMessageReceived(const IPC::Message&) override;
-  void MotionNotify(float x, float y);
-  void ButtonNotify(unsigned handle,
-                    EventType type,
-                    EventFlags flags,
-                    float x,
-                    float y);
-  void AxisNotify(float x,
-                  float y,
-                  int xoffset,
-                  int yoffset);
-  void PointerEnter(unsigned handle, float x, float y);
-  void PointerLeave(unsigned handle, float x, float y);
+  // Tells the GPU process to forget cursors nothing but the registry refers
+  // to anymore.
+  void EvictUnusedCursors();
+  void CursorTheme(uint64_t themed_types);
+  void EventBatch(const std::vector<WaylandInputEvent>& events);
+  void InputRingCreated(base::SharedMemoryHandle ring,
+                        uint32_t size,
+                        base::FileDescriptor doorbell);
   void KeyNotify(EventType type, unsigned code, int device_id);
   void VirtualKeyNotify(EventType type,
                         uint32_t key,
                         int device_id);
-  void TouchNotify(EventType type,
-                   float x,
-                   float y,
-                   int32_t touch_id,
-                   uint32_t time_stamp);
   void CloseWidget(unsigned handle);
 
   void OutputSizeChanged(unsigned width, unsigned height);
@@ -113,6 +132,9 @@ class WindowManagerWayland
   void WindowUnminimized(unsigned windowhandle);
   void WindowDeActivated(unsigned windowhandle);
   void WindowActivated(unsigned windowhandle);
+  void FrameTimingStats(unsigned windowhandle,
+                        const WaylandFrameTimingStats& stats);
+  void CanvasBufferReleased(unsigned windowhandle, uint32_t buffer_id);
 
   void DragEnter(unsigned windowhandle,
                  float x,
@@ -133,28 +155,96 @@ class WindowManagerWayland
   // Post a task to dispatch an event.
   void PostUiEvent(Event* event);
 
+  // How a batch of input events reached the browser.
+  enum InputTransport {
+    INPUT_TRANSPORT_IPC,
+    INPUT_TRANSPORT_SHARED_MEMORY
+  };
+
+  // An entry of |input_queue_|. Pointer and drag motion are kept as data so
+  // that consecutive samples can be merged, everything else is a task.
+  struct QueuedInput {
+    enum Type {
+      MOTION,
+      DRAG_MOTION,
+      TASK
+    };
+
+    QueuedInput();
+    ~QueuedInput();
+
+    Type type;
+    // MOTION and DRAG_MOTION. For DRAG_MOTION only handle, x, y and
+    // time_stamp are set.
+    WaylandInputEvent event;
+    InputTransport transport;
+    base::TimeTicks received_time;
+    // Samples merged into |event|, oldest first.
+    std::vector<WaylandInputEvent> history;
+    base::Closure task;
+  };
+
+  // Handles the messages of the GPU process sent by WaylandDisplay.
+  bool OnDisplayMessageReceived(const IPC::Message& message);
+
+  // Reads the events the GPU process has written to |input_ring_| before it
+  // sent the messages handled so far and queues them for dispatch.
+  void DrainInputRing();
+  void ResetInputRing();
+
+  // Everything the GPU process asks the UI thread to do goes through
+  // |input_queue_|, which keeps it in order and allows motion to be merged
+  // while the UI thread is busy. The queue is drained by one task.
+  void QueueTask(const base::Closure& task);
+  void QueueMotion(const QueuedInput& motion);
+  void ScheduleInputQueueDrain();
+  void DispatchInputQueue();
+
+  // |received_time| is when the batch was picked up from the transport.
+  void QueueEventBatch(const std::vector<WaylandInputEvent>& events,
+                       InputTransport transport,
+                       base::TimeTicks received_time);
+  void NotifyInputEvent(const WaylandInputEvent& event,
+                        InputTransport transport,
+                        base::TimeTicks received_time);
+  void NotifyKeyChange(EventType type, uint32_t key, int device_id);
+  // Records how long |event| spent in each stage of the input pipeline.
+  void RecordInputLatency(const WaylandInputEvent& event,
+                          InputTransport transport,
+                          base::TimeTicks received_time);
   void NotifyMotion(float x,
-                    float y);
+                    float y,
+                    base::TimeDelta time_stamp);
   void NotifyButtonPress(unsigned handle,
                          EventType type,
                          EventFlags flags,
                          float x,
-                         float y);
+                         float y,
+                         base::TimeDelta time_stamp);
   void NotifyAxis(float x,
                   float y,
-                  int xoffset,
-                  int yoffset);
+                  float xoffset,
+                  float yoffset,
+                  base::TimeDelta time_stamp);
+  void NotifyScroll(EventType type,
+                    float x,
+                    float y,
+                    float xoffset,
+                    float yoffset,
+                    base::TimeDelta time_stamp);
   void NotifyPointerEnter(unsigned handle,
                           float x,
-                          float y);
+                          float y,
+                          base::TimeDelta time_stamp);
   void NotifyPointerLeave(unsigned handle,
                           float x,
-                          float y);
+                          float y,
+                          base::TimeDelta time_stamp);
   void NotifyTouchEvent(EventType type,
                         float x,
                         float y,
                         int32_t touch_id,
-                        uint32_t time_stamp);
+                        base::TimeDelta time_stamp);
   void NotifyOutputSizeChanged(unsigned width,
                                unsigned height);
 
@@ -179,7 +269,32 @@ class WindowManagerWayland
   // Keyboard state.
   KeyboardEvdev keyboard_;
   ozonewayland::OzoneWaylandScreen* platform_screen_;
+  // Canvases of software rendered windows, by window handle. Not owned.
+  std::map<unsigned, OzoneWaylandCanvas*> canvases_;
   PlatformCursor platform_cursor_;
+  // Cursors registered with the GPU process and their ids. The references
+  // keep the cursors alive until the GPU process was told to evict them.
+  std::map<BitmapCursorOzone*, std::pair<scoped_refptr<BitmapCursorOzone>,
+                                         uint32_t> > registered_cursors_;
+  uint32_t next_cursor_id_;
+  // Mask of the cursor types in the cursor theme of the GPU process.
+  uint64_t themed_cursor_types_;
+  // Task runner of the browser IO thread, on which the GPU channel lives.
+  scoped_refptr<base::SingleThreadTaskRunner> io_task_runner_;
+  // Shared memory input transport, see WaylandInput_InputRingCreated.
+  scoped_ptr<ozonewayland::WaylandInputRingBuffer> input_ring_;
+  // Watches the doorbell of |input_ring_| on |io_task_runner_|. Owned, but
+  // created and destroyed on the IO thread.
+  class InputRingDoorbellWatcher;
+  InputRingDoorbellWatcher* doorbell_watcher_;
+  // Messages from WaylandDisplay received since WaylandInput_InputRingCreated,
+  // including the one being handled. Must see all of them, so this is the
+  // first handler registered with the proxy.
+  uint32_t ring_message_count_;
+  std::deque<QueuedInput> input_queue_;
+  bool input_queue_drain_scheduled_;
+  std::vector<WaylandInputEvent> coalesced_motion_history_;
+  uint64_t coalesced_event_count_;
   // Support weak pointers for attach & detach callbacks.
   base::WeakPtrFactory<WindowManagerWayland> weak_ptr_factory_;
   DISALLOW_COPY_AND_ASSIGN(WindowManagerWayland);
@@ -6,8 +6,11 @@
 #include "ozone/ui/desktop_aura/desktop_window_tree_host_ozone.h"
 
 #include <string>
+#include <utility>
 
 #include "base/bind.h"
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
 #include "ozone/ui/desktop_aura/desktop_drag_drop_client_wayland.h"
 #include "ozone/ui/desktop_aura/desktop_screen_wayland.h"
 #include "ui/aura/client/focus_client.h"
@@ -47,6 +50,25 @@ DEFINE_WINDOW_PROPERTY_KEY(
 DEFINE_WINDOW_PROPERTY_KEY(
     DesktopWindowTreeHostOzone*, kHostForRootWindow, NULL);
 
+namespace {
+
+// Interactive resizes only revisit a handful of sizes, e.g. when toggling
+// maximized state, so a few entries are enough.
+const size_t kMaxCachedWindowShapes = 4;
+
+}  // namespace
+
+DesktopWindowTreeHostOzone::WindowShapeKey::WindowShapeKey()
+    : maximized(false),
+      fullscreen(false) {
+}
+
+bool DesktopWindowTreeHostOzone::WindowShapeKey::operator==(
+    const WindowShapeKey& other) const {
+  return frame_type == other.frame_type && size == other.size &&
+         maximized == other.maximized && fullscreen == other.fullscreen;
+}
+
 DesktopWindowTreeHostOzone::DesktopWindowTreeHostOzone(
     internal::NativeWidgetDelegate* native_widget_delegate,
     DesktopNativeWidgetAura* desktop_native_widget_aura)
@@ -59,6 +81,9 @@ DesktopWindowTreeHostOzone::DesktopWindowTreeHostOzone(
       previous_maximize_bounds_(0, 0, 0, 0),
       window_(0),
       title_(base::string16()),
+      window_shape_applied_(false),
+      window_shape_updates_sent_(0),
+      window_shape_updates_skipped_(0),
       drag_drop_client_(NULL),
       native_widget_delegate_(native_widget_delegate),
       content_window_(NULL),
@@ -69,6 +94,8 @@ DesktopWindowTreeHostOzone::DesktopWindowTreeHostOzone(
 }
 
 DesktopWindowTreeHostOzone::~DesktopWindowTreeHostOzone() {
+  VLOG(1) << "Window shape updates: " << window_shape_updates_sent_
+          << " sent, " << window_shape_updates_skipped_ << " skipped";
   window()->ClearProperty(kHostForRootWindow);
   aura::client::SetWindowMoveClient(window(), NULL);
   desktop_native_widget_aura_->OnDesktopWindowTreeHostDestroyed(this);
@@ -369,6 +396,7 @@ gfx::Rect DesktopWindowTreeHostOzone::GetWorkAreaBoundsInScreen() const {
 
 void DesktopWindowTreeHostOzone::SetShape(SkRegion* native_region) {
   custom_window_shape_ = false;
+  window_shape_applied_ = false;
   gfx::Path window_mask;
 
   if (native_region) {
@@ -527,6 +555,7 @@ void DesktopWindowTreeHostOzone::FrameTypeChanged() {
   // swapable glass frame like on Windows, we still replace the frame because
   // the button assets don't update otherwise.
   native_widget_delegate_->AsWidget()->non_client_view()->UpdateFrame();
+  InvalidateWindowShape();
 }
 
 void DesktopWindowTreeHostOzone::SetFullscreen(bool fullscreen) {
@@ -1001,15 +1030,55 @@ void DesktopWindowTreeHostOzone::ResetWindowRegion() {
   if (custom_window_shape_)
     return;
 
+  WindowShapeKey key;
+  key.size = platform_window_->GetBounds().size();
+  key.maximized = IsMaximized();
+  key.fullscreen = IsFullscreen();
+  NonClientView* non_client_view =
+      native_widget_delegate_->AsWidget()->non_client_view();
+  if (non_client_view && non_client_view->frame_view())
+    key.frame_type = non_client_view->frame_view()->GetClassName();
+
+  // Moves and relayouts that keep the size hit this on every frame.
+  if (window_shape_applied_ && key == window_shape_key_) {
+    ++window_shape_updates_skipped_;
+  } else {
+    const SkPath& window_mask = GetWindowShape(key);
+    if (window_shape_applied_ && window_mask == window_shape_) {
+      ++window_shape_updates_skipped_;
+    } else {
+      platform_window_->SetWindowShape(window_mask);
+      window_shape_ = window_mask;
+      ++window_shape_updates_sent_;
+    }
+
+    window_shape_key_ = key;
+    window_shape_applied_ = true;
+  }
+
+  TRACE_COUNTER_ID2("ui", "WindowShapeUpdates", this,
+                    "sent", window_shape_updates_sent_,
+                    "skipped", window_shape_updates_skipped_);
+}
+
+const SkPath& DesktopWindowTreeHostOzone::GetWindowShape(
+    const WindowShapeKey& key) {
+  for (WindowShapeCache::iterator it = window_shape_cache_.begin();
+       it != window_shape_cache_.end(); ++it) {
+    if (it->first == key) {
+      window_shape_cache_.splice(window_shape_cache_.begin(),
+                                 window_shape_cache_, it);
+      return window_shape_cache_.front().second;
+    }
+  }
+
   gfx::Path window_mask;
-  const gfx::Rect& bounds_in_pixels = platform_window_->GetBounds();
-  if (!IsMaximized() && !IsFullscreen()) {
+  if (!key.maximized && !key.fullscreen) {
     views::Widget* widget = native_widget_delegate_->AsWidget();
     if (widget->non_client_view()) {
       // Some frame views define a custom (non-rectangular) window mask. If
       // so, use it to define the window shape. If not, fall through.
-      widget->non_client_view()->GetWindowMask(bounds_in_pixels.size(),
-                                               &window_mask);
+      widget->non_client_view()->GetWindowMask(key.size, &window_mask);
     }
   }
 
@@ -1017,12 +1086,22 @@ void DesktopWindowTreeHostOzone::ResetWindowRegion() {
     // TODO(kalyan): handle the case where window has system borders..
     SkRect rect = { 0,
                     0,
-                    SkIntToScalar(bounds_in_pixels.width()),
-                    SkIntToScalar(bounds_in_pixels.height()) };
+                    SkIntToScalar(key.size.width()),
+                    SkIntToScalar(key.size.height()) };
     window_mask.addRect(rect);
   }
 
-  platform_window_->SetWindowShape(window_mask);
+  window_shape_cache_.push_front(
+      std::make_pair(key, static_cast<const SkPath&>(window_mask)));
+  if (window_shape_cache_.size() > kMaxCachedWindowShapes)
+    window_shape_cache_.pop_back();
+
+  return window_shape_cache_.front().second;
+}
+
+void DesktopWindowTreeHostOzone::InvalidateWindowShape() {
+  window_shape_cache_.clear();
+  window_shape_applied_ = false;
 }
 
 // static
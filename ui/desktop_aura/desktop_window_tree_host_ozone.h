@@ -12,7 +12,9 @@
 #include <vector>
 
 #include "base/basictypes.h"
+#include "third_party/skia/include/core/SkPath.h"
 #include "ui/aura/window_tree_host.h"
+#include "ui/gfx/geometry/size.h"
 #include "ui/platform_window/platform_window_delegate.h"
 #include "ui/views/widget/desktop_aura/desktop_window_tree_host.h"
 
@@ -170,6 +172,21 @@ class VIEWS_EXPORT DesktopWindowTreeHostOzone
 
   typedef unsigned RootWindowState;
 
+  // Everything the default window shape depends on. Frame views compute their
+  // window mask from the window size and maximized/fullscreen state only.
+  struct WindowShapeKey {
+    WindowShapeKey();
+    bool operator==(const WindowShapeKey& other) const;
+
+    // Class name of the frame view, empty if there is none.
+    std::string frame_type;
+    gfx::Size size;
+    bool maximized;
+    bool fullscreen;
+  };
+
+  typedef std::list<std::pair<WindowShapeKey, SkPath> > WindowShapeCache;
+
   // Initializes our Ozone surface to draw on. This method performs all
   // initialization related to talking to the Ozone server.
   void InitOzoneWindow(const views::Widget::InitParams& params);
@@ -182,6 +199,11 @@ class VIEWS_EXPORT DesktopWindowTreeHostOzone
   gfx::Rect ToDIPRect(const gfx::Rect& rect_in_pixels) const;
   gfx::Rect ToPixelRect(const gfx::Rect& rect_in_dip) const;
   void ResetWindowRegion();
+  // Returns the default window shape for |key|, computing it with the frame
+  // view on a cache miss.
+  const SkPath& GetWindowShape(const WindowShapeKey& key);
+  // Forgets the cached and last applied window shapes.
+  void InvalidateWindowShape();
 
   RootWindowState state_;
   bool has_capture_;
@@ -194,6 +216,16 @@ class VIEWS_EXPORT DesktopWindowTreeHostOzone
   gfx::AcceleratedWidget window_;
   base::string16 title_;
 
+  // Recently used default window shapes, most recent first.
+  WindowShapeCache window_shape_cache_;
+  // Key and shape of the last default window shape handed to
+  // |platform_window_|, valid if |window_shape_applied_| is set.
+  WindowShapeKey window_shape_key_;
+  SkPath window_shape_;
+  bool window_shape_applied_;
+  unsigned window_shape_updates_sent_;
+  unsigned window_shape_updates_skipped_;
+
   // Owned by DesktopNativeWidgetAura.
   DesktopDragDropClientWayland* drag_drop_client_;
   views::internal::NativeWidgetDelegate* native_widget_delegate_;
@@ -8,34 +8,48 @@
 #include <EGL/egl.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
 #if defined(ENABLE_DRM_SUPPORT)
 #include <gbm.h>
 #include <libdrm/drm.h>
 #include <xf86drm.h>
 #endif
+#include <algorithm>
 #include <string>
 
 #include "base/bind.h"
 #include "base/files/file_path.h"
+#include "base/files/scoped_file.h"
 #include "base/message_loop/message_loop.h"
 #include "base/native_library.h"
 #include "base/stl_util.h"
+#include "base/trace_event/trace_event.h"
 #include "ipc/ipc_sender.h"
 #include "ozone/platform/messages.h"
 #include "ozone/wayland/data_device.h"
+#include "ozone/wayland/display_event_watcher.h"
+#include "ozone/wayland/display_message_filter.h"
 #include "ozone/wayland/display_poll_thread.h"
 #include "ozone/wayland/egl/surface_ozone_wayland.h"
+#include "ozone/wayland/egl/wayland_frame_clock.h"
 #if defined(ENABLE_DRM_SUPPORT)
 #include "ozone/wayland/egl/wayland_pixmap.h"
+#include "ozone/wayland/egl/wayland_pixmap_pool.h"
 #endif
 #include "ozone/wayland/input/cursor.h"
+#include "ozone/wayland/input/cursor_theme.h"
+#include "ozone/wayland/input_ring_buffer.h"
+#include "ozone/wayland/protocol/linux-dmabuf-client-protocol.h"
+#include "ozone/wayland/protocol/presentation-time-client-protocol.h"
 #include "ozone/wayland/protocol/text-client-protocol.h"
+#include "ozone/wayland/protocol/viewporter-client-protocol.h"
 #if defined(ENABLE_DRM_SUPPORT)
 #include "ozone/wayland/protocol/wayland-drm-protocol.h"
 #endif
 #include "ozone/wayland/screen.h"
 #include "ozone/wayland/seat.h"
 #include "ozone/wayland/shell/shell.h"
+#include "ozone/wayland/shm_surface.h"
 #include "ozone/wayland/window.h"
 #include "ui/ozone/public/native_pixmap.h"
 #include "ui/ozone/public/surface_ozone_canvas.h"
@@ -76,29 +90,60 @@ static const struct wl_drm_listener drm_listener = {
 #endif
 
 namespace ozonewayland {
+namespace {
+
+// Number of input events the shared memory ring can hold.
+const size_t kInputRingCapacity = 1024;
+
+#if defined(ENABLE_DRM_SUPPORT)
+// Memory the buffers of released native pixmaps may keep for reuse.
+const size_t kPixmapPoolBudgetBytes = 64 * 1024 * 1024;
+#endif
+
+}  // namespace
+
 WaylandDisplay* WaylandDisplay::instance_ = NULL;
 
 WaylandDisplay::WaylandDisplay() : SurfaceFactoryOzone(),
     display_(NULL),
     registry_(NULL),
+    input_queue_(NULL),
+    frame_queue_(NULL),
     compositor_(NULL),
+    compositor_version_(0),
+    subcompositor_(NULL),
+    viewporter_(NULL),
     data_device_manager_(NULL),
     shell_(NULL),
     shm_(NULL),
     text_input_manager_(NULL),
+    presentation_(NULL),
+    linux_dmabuf_(NULL),
     primary_screen_(NULL),
     primary_seat_(NULL),
     display_poll_thread_(NULL),
+    display_event_watcher_(NULL),
     device_(NULL),
     m_deviceName(NULL),
     sender_(NULL),
     loop_(NULL),
+    message_filter_(new WaylandDisplayMessageFilter()),
+    message_filter_added_(false),
+    send_from_io_thread_(false),
     screen_list_(),
     seat_list_(),
     widget_map_(),
+    ring_message_count_(0),
+    input_ring_active_(false),
+    input_event_count_(0),
+    input_message_count_(0),
+    input_queue_events_(0),
+    default_queue_events_(0),
+    wakeup_count_(0),
     serial_(0),
     processing_events_(false),
     m_authenticated_(false),
+    presentation_clock_is_monotonic_(false),
     m_fd_(-1),
     m_capabilities_(0),
     weak_ptr_factory_(this) {
@@ -108,10 +153,36 @@ WaylandDisplay::~WaylandDisplay() {
   Terminate();
 }
 
+// static
+base::TimeTicks WaylandDisplay::ProtocolTimeToTimeTicks(uint32_t time_stamp,
+                                                        base::TimeTicks now) {
+  const int32_t kMaxEventAgeMs = 1000;
+  const int32_t kMaxClockSkewMs = 2;
+  if (!time_stamp)
+    return now;
+
+  uint32_t now_ms =
+      static_cast<uint32_t>((now - base::TimeTicks()).InMilliseconds());
+  int32_t age = static_cast<int32_t>(now_ms - time_stamp);
+  if (age > kMaxEventAgeMs || age < -kMaxClockSkewMs)
+    return now;
+
+  return now - base::TimeDelta::FromMilliseconds(std::max(age, 0));
+}
+
 const std::list<WaylandScreen*>& WaylandDisplay::GetScreenList() const {
   return screen_list_;
 }
 
+WaylandScreen* WaylandDisplay::GetScreen(wl_output* output) const {
+  for (WaylandScreen* screen : screen_list_) {
+    if (screen->output() == output)
+      return screen;
+  }
+
+  return NULL;
+}
+
 WaylandWindow* WaylandDisplay::GetWindow(unsigned window_handle) const {
   return GetWidget(window_handle);
 }
@@ -120,6 +191,27 @@ struct wl_text_input_manager* WaylandDisplay::GetTextInputManager() const {
   return text_input_manager_;
 }
 
+bool WaylandDisplay::PresentationTimeToTimeTicks(uint32_t tv_sec_hi,
+                                                 uint32_t tv_sec_lo,
+                                                 uint32_t tv_nsec,
+                                                 base::TimeTicks* time) const {
+  if (!presentation_clock_is_monotonic_)
+    return false;
+
+  // base::TimeTicks counts microseconds of CLOCK_MONOTONIC.
+  int64_t seconds = (static_cast<int64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+  *time = base::TimeTicks::FromInternalValue(
+      seconds * base::Time::kMicrosecondsPerSecond +
+      tv_nsec / base::Time::kNanosecondsPerMicrosecond);
+  return true;
+}
+
+bool WaylandDisplay::IsDmabufFormatSupported(uint32_t format,
+                                             uint64_t modifier) const {
+  DmabufFormatMap::const_iterator it = dmabuf_formats_.find(format);
+  return it != dmabuf_formats_.end() && it->second.count(modifier);
+}
+
 void WaylandDisplay::FlushDisplay() {
   wl_display_flush(display_);
 }
@@ -134,6 +226,15 @@ void WaylandDisplay::DestroyWindow(unsigned w) {
     StopProcessingEvents();
 }
 
+void WaylandDisplay::RegisterFrameClock(unsigned handle,
+                                        WaylandFrameClock* clock) {
+  frame_clocks_[handle] = clock;
+}
+
+void WaylandDisplay::UnregisterFrameClock(unsigned handle) {
+  frame_clocks_.erase(handle);
+}
+
 gfx::AcceleratedWidget WaylandDisplay::GetNativeWindow(unsigned window_handle) {
   WaylandWindow* widget = GetWidget(window_handle);
   DCHECK(widget);
@@ -149,6 +250,12 @@ bool WaylandDisplay::InitializeHardware() {
     return false;
   }
 
+  if (getenv("OZONE_WAYLAND_INPUT_RING_BUFFER")) {
+    input_ring_.reset(new WaylandInputRingBuffer());
+    if (!input_ring_->Create(kInputRingCapacity))
+      input_ring_.reset();
+  }
+
   // Ensure we are processing wayland event requests. This needs to be done here
   // so we start polling before sandbox is initialized.
   StartProcessingEvents();
@@ -236,11 +343,8 @@ scoped_refptr<ui::NativePixmap> WaylandDisplay::CreateNativePixmap(
     gfx::BufferFormat format,
     gfx::BufferUsage usage) {
 #if defined(ENABLE_DRM_SUPPORT)
-  if (usage == MAP)
-    return NULL;
-
-  scoped_refptr<WaylandPixmap> pixmap(new WaylandPixmap());
-  if (!pixmap->Initialize(device_, format, size))
+  scoped_refptr<WaylandPixmap> pixmap(new WaylandPixmap(pixmap_pool_.get()));
+  if (!pixmap->Initialize(device_, format, usage, size))
     return NULL;
 
   return pixmap;
@@ -249,22 +353,39 @@ scoped_refptr<ui::NativePixmap> WaylandDisplay::CreateNativePixmap(
 #endif
 }
 
+std::vector<gfx::BufferFormat> WaylandDisplay::GetScanoutFormats(
+    gfx::AcceleratedWidget widget) {
+  std::vector<gfx::BufferFormat> formats;
+#if defined(ENABLE_DRM_SUPPORT)
+  static const gfx::BufferFormat kPixmapFormats[] = {
+    gfx::BufferFormat::BGRA_8888,
+    gfx::BufferFormat::BGRX_8888,
+    gfx::BufferFormat::RGBA_8888,
+    gfx::BufferFormat::YUV_420,
+    gfx::BufferFormat::YUV_420_BIPLANAR
+  };
+
+  if (!linux_dmabuf_ || !device_)
+    return formats;
+
+  for (size_t i = 0; i < arraysize(kPixmapFormats); ++i) {
+    uint32_t fourcc =
+        WaylandPixmap::GetFourccFromBufferFormat(kPixmapFormats[i]);
+    if (IsDmabufFormatSupported(fourcc, kDrmFormatModInvalid))
+      formats.push_back(kPixmapFormats[i]);
+  }
+#endif
+  return formats;
+}
+
 scoped_ptr<ui::SurfaceOzoneCanvas> WaylandDisplay::CreateCanvasForWidget(
     gfx::AcceleratedWidget widget) {
-  LOG(FATAL) << "The browser process has attempted to start the GPU process in "
-             << "software rendering mode. Software rendering is not supported "
-             << "in Ozone-Wayland, so this is fatal. Usually this error occurs "
-             << "because the GPU process crashed in hardware rendering mode, "
-             << "often due to failure to initialize EGL. To debug the GPU "
-             << "process, start Chrome with --gpu-startup-dialog so that the "
-             << "GPU process pauses on startup, then attach to it with "
-             << "'gdb -p' and run the command 'signal SIGUSR1' in order to "
-             << "unpause it. If you have xterm then it is easier to run "
-             << "'chrome --no-sandbox --gpu-launcher='xterm -title renderer "
-             << "-e gdb --eval-command=run --args''";
-
-  // This code will obviously never be reached, but it placates -Wreturn-type.
-  return scoped_ptr<ui::SurfaceOzoneCanvas>();
+  if (canvas_factory_.is_null()) {
+    NOTREACHED() << "Software rendering is only done by the browser process";
+    return scoped_ptr<ui::SurfaceOzoneCanvas>();
+  }
+
+  return canvas_factory_.Run(widget);
 }
 
 void WaylandDisplay::InitializeDisplay() {
@@ -278,6 +399,9 @@ void WaylandDisplay::InitializeDisplay() {
     WaylandDisplay::DisplayHandleGlobal
   };
 
+  // Needs to exist before the seat is bound during the roundtrip below.
+  input_queue_ = wl_display_create_queue(display_);
+  frame_queue_ = wl_display_create_queue(display_);
   registry_ = wl_display_get_registry(display_);
   wl_registry_add_listener(registry_, &registry_all, this);
   shell_ = new WaylandShell();
@@ -287,7 +411,21 @@ void WaylandDisplay::InitializeDisplay() {
     return;
   }
 
-  display_poll_thread_ = new WaylandDisplayPollThread(display_);
+  // linux-dmabuf advertises its formats after being bound in the roundtrip
+  // above. Collect them before events are dispatched on another thread.
+  if (linux_dmabuf_ && wl_display_roundtrip(display_) < 0) {
+    Terminate();
+    return;
+  }
+
+  if (shm_)
+    cursor_theme_.reset(new WaylandCursorTheme(shm_));
+
+  display_poll_thread_ = new WaylandDisplayPollThread(display_,
+                                                      poll_thread_policy_);
+  const char* event_source = getenv("OZONE_WAYLAND_EVENT_SOURCE");
+  if (event_source && !strcmp(event_source, "io_pump"))
+    display_event_watcher_ = new WaylandDisplayEventWatcher(display_);
 }
 
 WaylandWindow* WaylandDisplay::CreateAcceleratedSurface(unsigned w) {
@@ -299,24 +437,45 @@ WaylandWindow* WaylandDisplay::CreateAcceleratedSurface(unsigned w) {
 
 void WaylandDisplay::StartProcessingEvents() {
   DCHECK(display_poll_thread_);
-  // Start polling for wayland events.
-  if (!processing_events_) {
+  if (processing_events_)
+    return;
+
+  if (display_event_watcher_) {
+    // The display is watched from the IO thread of the channel to the browser,
+    // starting as soon as |message_filter_| is attached to it.
+    message_filter_->SetAttachedCallback(
+        base::Bind(&WaylandDisplayEventWatcher::StartProcessingEvents,
+                   base::Unretained(display_event_watcher_)));
+  } else {
+    // Start polling for wayland events.
     display_poll_thread_->StartProcessingEvents();
-    processing_events_ = true;
   }
+
+  processing_events_ = true;
 }
 
 void WaylandDisplay::StopProcessingEvents() {
   DCHECK(display_poll_thread_);
-  // Start polling for wayland events.
-  if (processing_events_) {
+  if (!processing_events_)
+    return;
+
+  if (display_event_watcher_) {
+    // Makes sure the watcher isn't started from the IO thread meanwhile.
+    message_filter_->SetAttachedCallback(
+        WaylandDisplayMessageFilter::AttachedCallback());
+    display_event_watcher_->StopProcessingEvents();
+  } else {
     display_poll_thread_->StopProcessingEvents();
-    processing_events_ = false;
   }
+
+  processing_events_ = false;
 }
 
 void WaylandDisplay::Terminate() {
-  loop_ = NULL;
+  {
+    base::AutoLock lock(dispatch_lock_);
+    loop_ = NULL;
+  }
   if (!widget_map_.empty()) {
     STLDeleteValues(&widget_map_);
     widget_map_.clear();
@@ -330,10 +489,52 @@ void WaylandDisplay::Terminate() {
 
   screen_list_.clear();
   seat_list_.clear();
+  // The cursors of the seats were the last users of the theme buffers.
+  cursor_theme_.reset();
+  // All proxies on the queue are gone with the seats.
+  if (input_queue_) {
+    wl_event_queue_destroy(input_queue_);
+    input_queue_ = NULL;
+  }
+
+#if defined(ENABLE_DRM_SUPPORT)
+  // Parked buffers are on the frame queue. Pixmaps still alive destroy their
+  // buffers themselves from now on.
+  if (pixmap_pool_.get()) {
+    pixmap_pool_->Shutdown();
+    pixmap_pool_ = NULL;
+  }
+#endif
+
+  // Frame clocks are shut down along with their surfaces, which are gone.
+  if (frame_queue_) {
+    wl_event_queue_destroy(frame_queue_);
+    frame_queue_ = NULL;
+  }
 
   if (text_input_manager_)
     wl_text_input_manager_destroy(text_input_manager_);
 
+  if (presentation_) {
+    wp_presentation_destroy(presentation_);
+    presentation_ = NULL;
+  }
+
+  if (linux_dmabuf_) {
+    zwp_linux_dmabuf_v1_destroy(linux_dmabuf_);
+    linux_dmabuf_ = NULL;
+  }
+
+  if (viewporter_) {
+    wp_viewporter_destroy(viewporter_);
+    viewporter_ = NULL;
+  }
+
+  if (subcompositor_) {
+    wl_subcompositor_destroy(subcompositor_);
+    subcompositor_ = NULL;
+  }
+
   if (data_device_manager_)
     wl_data_device_manager_destroy(data_device_manager_);
 
@@ -358,6 +559,11 @@ void WaylandDisplay::Terminate() {
   if (registry_)
     wl_registry_destroy(registry_);
 
+  if (display_event_watcher_) {
+    message_filter_->SetAttachedCallback(
+        WaylandDisplayMessageFilter::AttachedCallback());
+    delete display_event_watcher_;
+  }
   delete display_poll_thread_;
 
   if (display_) {
@@ -366,8 +572,20 @@ void WaylandDisplay::Terminate() {
     display_ = NULL;
   }
 
-  while (!deferred_messages_.empty())
-    deferred_messages_.pop();
+  {
+    base::AutoLock lock(dispatch_lock_);
+    while (!deferred_messages_.empty()) {
+      delete deferred_messages_.front();
+      deferred_messages_.pop();
+    }
+  }
+
+  {
+    base::AutoLock lock(input_lock_);
+    pending_input_events_.clear();
+    input_ring_active_ = false;
+    input_ring_.reset();
+  }
 
   instance_ = NULL;
 }
@@ -492,23 +710,31 @@ void WaylandDisplay::MoveWindow(unsigned widget,
   popup->Move(shell_type, shell_parent, rect);
 }
 
-void WaylandDisplay::AddRegion(unsigned handle, int left, int top,
-                               int right, int bottom) {
+void WaylandDisplay::SetRegion(unsigned handle,
+                               const std::vector<gfx::Rect>& opaque_region,
+                               const std::vector<gfx::Rect>& input_region) {
   WaylandWindow* widget = GetWidget(handle);
   DCHECK(widget);
-  widget->AddRegion(left, top, right, bottom);
+  widget->SetRegion(opaque_region, input_region);
 }
 
-void WaylandDisplay::SubRegion(unsigned handle, int left, int top,
-                               int right, int bottom) {
-  WaylandWindow* widget = GetWidget(handle);
-  DCHECK(widget);
-  widget->SubRegion(left, top, right, bottom);
+void WaylandDisplay::RegisterCursor(uint32_t id,
+                                    const std::vector<SkBitmap>& bitmaps,
+                                    const gfx::Point& hotspot,
+                                    int frame_delay_ms) {
+  primary_seat_->RegisterCursor(id, bitmaps, hotspot, frame_delay_ms);
+}
+
+void WaylandDisplay::SetCursor(uint32_t id) {
+  primary_seat_->SetCursor(id);
+}
+
+void WaylandDisplay::EvictCursor(uint32_t id) {
+  primary_seat_->EvictCursor(id);
 }
 
-void WaylandDisplay::SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                                     const gfx::Point& location) {
-  primary_seat_->SetCursorBitmap(bitmaps, location);
+void WaylandDisplay::SetCursorType(ui::WaylandCursorType type) {
+  primary_seat_->SetCursorType(type);
 }
 
 void WaylandDisplay::MoveCursor(const gfx::Point& location) {
@@ -548,6 +774,46 @@ void WaylandDisplay::DragWillBeRejected(uint32_t serial) {
   primary_seat_->GetDataDevice()->DragWillBeRejected(serial);
 }
 
+void WaylandDisplay::CanvasBuffersCreated(unsigned handle,
+                                          base::FileDescriptor shm,
+                                          const gfx::Size& size,
+                                          uint32_t count,
+                                          uint32_t first_id) {
+  base::ScopedFD shm_fd(shm.fd);
+  WaylandWindow* widget = GetWidget(handle);
+  if (!widget) {
+    LOG(ERROR) << "Canvas buffers for unknown window " << handle;
+    return;
+  }
+
+  widget->ShmSurface()->SetBuffers(shm_fd.Pass(), size, count, first_id);
+}
+
+void WaylandDisplay::CanvasPresent(unsigned handle,
+                                   uint32_t buffer_id,
+                                   const gfx::Rect& damage) {
+  WaylandWindow* widget = GetWidget(handle);
+  if (!widget)
+    return;
+
+  widget->ShmSurface()->Present(buffer_id, damage);
+  FlushDisplay();
+}
+
+void WaylandDisplay::CanvasDestroyed(unsigned handle) {
+  if (GetWidget(handle))
+    DestroyWindow(handle);
+}
+
+void WaylandDisplay::GetFrameTimingStats(unsigned handle) {
+  FrameClockMap::const_iterator it = frame_clocks_.find(handle);
+  if (it == frame_clocks_.end())
+    return;
+
+  Dispatch(new WaylandWindow_FrameTimingStats(handle,
+                                              it->second->timing_stats()));
+}
+
 #if defined(ENABLE_DRM_SUPPORT)
 void WaylandDisplay::DrmHandleDevice(const char* device) {
   drm_magic_t magic;
@@ -586,7 +852,10 @@ void WaylandDisplay::DrmAuthenticated() {
     LOG(ERROR) << "WaylandDisplay: Failed to create GBM Device.";
     close(m_fd_);
     m_fd_ = -1;
+    return;
   }
+
+  pixmap_pool_ = new WaylandPixmapPool(kPixmapPoolBudgetBytes);
 }
 
 void WaylandDisplay::SetDrmCapabilities(uint32_t value) {
@@ -603,8 +872,18 @@ void WaylandDisplay::DisplayHandleGlobal(void *data,
   WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
 
   if (strcmp(interface, "wl_compositor") == 0) {
+    // Version 3 adds buffer scales, which cursor surfaces use on HiDPI
+    // outputs.
+    disp->compositor_version_ = std::min(version, 3u);
     disp->compositor_ = static_cast<wl_compositor*>(
-        wl_registry_bind(registry, name, &wl_compositor_interface, 1));
+        wl_registry_bind(registry, name, &wl_compositor_interface,
+                         disp->compositor_version_));
+  } else if (strcmp(interface, "wl_subcompositor") == 0) {
+    disp->subcompositor_ = static_cast<wl_subcompositor*>(
+        wl_registry_bind(registry, name, &wl_subcompositor_interface, 1));
+  } else if (strcmp(interface, "wp_viewporter") == 0) {
+    disp->viewporter_ = static_cast<wp_viewporter*>(
+        wl_registry_bind(registry, name, &wp_viewporter_interface, 1));
   } else if (strcmp(interface, "wl_data_device_manager") == 0) {
     disp->data_device_manager_ = static_cast<wl_data_device_manager*>(
         wl_registry_bind(registry, name, &wl_data_device_manager_interface, 1));
@@ -617,7 +896,7 @@ void WaylandDisplay::DisplayHandleGlobal(void *data,
     wl_drm_add_listener(m_drm, &drm_listener, disp);
 #endif
   } else if (strcmp(interface, "wl_output") == 0) {
-    WaylandScreen* screen = new WaylandScreen(disp->registry(), name);
+    WaylandScreen* screen = new WaylandScreen(disp->registry(), name, version);
     if (!disp->screen_list_.empty())
       NOTIMPLEMENTED() << "Multiple screens support is not implemented";
 
@@ -629,7 +908,7 @@ void WaylandDisplay::DisplayHandleGlobal(void *data,
     // valid data device manager. We should ideally be robust to the compositor
     // advertising a wl_seat first. No known compositor does this, fortunately.
     CHECK(disp->data_device_manager_);
-    WaylandSeat* seat = new WaylandSeat(disp, name);
+    WaylandSeat* seat = new WaylandSeat(disp, name, version);
     disp->seat_list_.push_back(seat);
     disp->primary_seat_ = disp->seat_list_.front();
   } else if (strcmp(interface, "wl_shm") == 0) {
@@ -638,18 +917,126 @@ void WaylandDisplay::DisplayHandleGlobal(void *data,
   } else if (strcmp(interface, "wl_text_input_manager") == 0) {
     disp->text_input_manager_ = static_cast<wl_text_input_manager*>(
         wl_registry_bind(registry, name, &wl_text_input_manager_interface, 1));
+  } else if (strcmp(interface, "wp_presentation") == 0) {
+    static const struct wp_presentation_listener presentation_listener = {
+      WaylandDisplay::PresentationClockId
+    };
+    disp->presentation_ = static_cast<wp_presentation*>(
+        wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+    wp_presentation_add_listener(disp->presentation_,
+                                 &presentation_listener,
+                                 disp);
+  } else if (strcmp(interface, "zwp_linux_dmabuf_v1") == 0) {
+    // Buffers are created with create_immed, which needs version 2.
+    if (version < 2)
+      return;
+
+    static const struct zwp_linux_dmabuf_v1_listener linux_dmabuf_listener = {
+      WaylandDisplay::DmabufFormat,
+      WaylandDisplay::DmabufModifier
+    };
+    disp->linux_dmabuf_ = static_cast<zwp_linux_dmabuf_v1*>(
+        wl_registry_bind(registry,
+                         name,
+                         &zwp_linux_dmabuf_v1_interface,
+                         std::min(version, 3u)));
+    zwp_linux_dmabuf_v1_add_listener(disp->linux_dmabuf_,
+                                     &linux_dmabuf_listener,
+                                     disp);
   } else {
     disp->shell_->Initialize(registry, name, interface, version);
   }
 }
 
+// static
+void WaylandDisplay::PresentationClockId(void* data,
+                                         struct wp_presentation* presentation,
+                                         uint32_t clk_id) {
+  WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
+  disp->presentation_clock_is_monotonic_ = clk_id == CLOCK_MONOTONIC;
+}
+
+// static
+void WaylandDisplay::DmabufFormat(void* data,
+                                  struct zwp_linux_dmabuf_v1* linux_dmabuf,
+                                  uint32_t format) {
+  // Formats advertised without modifiers can be imported with the layout
+  // implied by the driver.
+  WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
+  disp->dmabuf_formats_[format].insert(kDrmFormatModInvalid);
+}
+
+// static
+void WaylandDisplay::DmabufModifier(void* data,
+                                    struct zwp_linux_dmabuf_v1* linux_dmabuf,
+                                    uint32_t format,
+                                    uint32_t modifier_hi,
+                                    uint32_t modifier_lo) {
+  WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
+  uint64_t modifier = (static_cast<uint64_t>(modifier_hi) << 32) | modifier_lo;
+  disp->dmabuf_formats_[format].insert(modifier);
+}
+
 void WaylandDisplay::OnChannelEstablished(IPC::Sender* sender) {
-  loop_ = base::MessageLoop::current();
-  sender_ = sender;
-  while (!deferred_messages_.empty()) {
-    Dispatch(deferred_messages_.front());
-    deferred_messages_.pop();
+  // The filter is added to the channel before GPU platform support is told
+  // about it, but it is attached asynchronously on the IO thread. Messages
+  // sent meanwhile are held back by the filter, so using it only depends on
+  // whether it was added at all.
+  send_from_io_thread_ = message_filter_added_ &&
+                         !getenv("OZONE_WAYLAND_SEND_ON_MAIN_THREAD");
+  VLOG(1) << "Sending to the browser from the "
+          << (send_from_io_thread_ ? "IO" : "main") << " thread.";
+  {
+    // Messages deferred so far are older than any input event still pending,
+    // so they go out before the next Dispatch() flushes those.
+    base::AutoLock lock(dispatch_lock_);
+    loop_ = base::MessageLoop::current();
+    sender_ = sender;
+    while (!deferred_messages_.empty()) {
+      DispatchLocked(deferred_messages_.front());
+      deferred_messages_.pop();
+    }
   }
+
+  if (display_event_watcher_ && !message_filter_added_) {
+    LOG(WARNING) << "No IO thread to watch the display on, falling back to "
+                    "the poll thread.";
+    StopProcessingEvents();
+    delete display_event_watcher_;
+    display_event_watcher_ = NULL;
+    StartProcessingEvents();
+  }
+
+  SendOverlayCapabilities();
+  Dispatch(new WaylandInput_CursorTheme(
+      cursor_theme_ ? cursor_theme_->GetAvailableTypes() : 0));
+
+  if (input_ring_) {
+    // Everything queued so far goes through IPC, so that nothing written to
+    // the ring can be seen by the browser before the ring itself.
+    FlushInputEvents();
+    base::AutoLock lock(input_lock_);
+    Dispatch(new WaylandInput_InputRingCreated(input_ring_->ShareHandle(),
+                                               input_ring_->size(),
+                                               input_ring_->ShareDoorbell()));
+    input_ring_active_ = true;
+  }
+}
+
+void WaylandDisplay::SendOverlayCapabilities() {
+  uint32_t formats = 0;
+#if defined(ENABLE_DRM_SUPPORT)
+  static_assert(static_cast<int>(gfx::BufferFormat::LAST) < 32,
+                "gfx::BufferFormat doesn't fit into the format mask");
+  if (subcompositor_) {
+    std::vector<gfx::BufferFormat> scanout_formats =
+        GetScanoutFormats(gfx::kNullAcceleratedWidget);
+    for (size_t i = 0; i < scanout_formats.size(); ++i)
+      formats |= 1u << static_cast<int>(scanout_formats[i]);
+  }
+#endif
+
+  Dispatch(new WaylandInput_OverlayCapabilities(formats, viewporter_ != NULL));
 }
 
 bool WaylandDisplay::OnMessageReceived(const IPC::Message& message) {
@@ -659,9 +1046,11 @@ bool WaylandDisplay::OnMessageReceived(const IPC::Message& message) {
   IPC_MESSAGE_HANDLER(WaylandDisplay_Create, CreateWidget)
   IPC_MESSAGE_HANDLER(WaylandDisplay_MoveWindow, MoveWindow)
   IPC_MESSAGE_HANDLER(WaylandDisplay_Title, SetWidgetTitle)
-  IPC_MESSAGE_HANDLER(WaylandDisplay_AddRegion, AddRegion)
-  IPC_MESSAGE_HANDLER(WaylandDisplay_SubRegion, SubRegion)
-  IPC_MESSAGE_HANDLER(WaylandDisplay_CursorSet, SetCursorBitmap)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_SetRegion, SetRegion)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CursorRegister, RegisterCursor)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CursorSet, SetCursor)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CursorEvict, EvictCursor)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CursorSetType, SetCursorType)
   IPC_MESSAGE_HANDLER(WaylandDisplay_MoveCursor, MoveCursor)
   IPC_MESSAGE_HANDLER(WaylandDisplay_ImeReset, ResetIme)
   IPC_MESSAGE_HANDLER(WaylandDisplay_ShowInputPanel, ShowInputPanel)
@@ -670,6 +1059,10 @@ bool WaylandDisplay::OnMessageReceived(const IPC::Message& message) {
   IPC_MESSAGE_HANDLER(WaylandDisplay_RequestSelectionData, RequestSelectionData)
   IPC_MESSAGE_HANDLER(WaylandDisplay_DragWillBeAccepted, DragWillBeAccepted)
   IPC_MESSAGE_HANDLER(WaylandDisplay_DragWillBeRejected, DragWillBeRejected)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CanvasBuffersCreated, CanvasBuffersCreated)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CanvasPresent, CanvasPresent)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CanvasDestroyed, CanvasDestroyed)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_GetFrameTimingStats, GetFrameTimingStats)
   IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
@@ -677,34 +1070,84 @@ bool WaylandDisplay::OnMessageReceived(const IPC::Message& message) {
 }
 
 IPC::MessageFilter* WaylandDisplay::GetMessageFilter() {
-  return NULL;
+  message_filter_added_ = true;
+  return message_filter_.get();
 }
 
-void WaylandDisplay::MotionNotify(float x, float y) {
-  Dispatch(new WaylandInput_MotionNotify(x, y));
+void WaylandDisplay::MotionNotify(float x, float y, uint32_t time_stamp) {
+  ui::WaylandInputEvent event;
+  event.type = ui::WaylandInputEvent::MOTION;
+  event.x = x;
+  event.y = y;
+  event.time_stamp = time_stamp;
+  QueueInputEvent(event);
 }
 
 void WaylandDisplay::ButtonNotify(unsigned handle,
                                   ui::EventType type,
                                   ui::EventFlags flags,
                                   float x,
-                                  float y) {
-  Dispatch(new WaylandInput_ButtonNotify(handle, type, flags, x, y));
+                                  float y,
+                                  uint32_t time_stamp) {
+  ui::WaylandInputEvent event;
+  event.type = ui::WaylandInputEvent::BUTTON;
+  event.handle = handle;
+  event.event_type = type;
+  event.flags = flags;
+  event.x = x;
+  event.y = y;
+  event.time_stamp = time_stamp;
+  QueueInputEvent(event);
 }
 
 void WaylandDisplay::AxisNotify(float x,
                                 float y,
-                                int xoffset,
-                                int yoffset) {
-  Dispatch(new WaylandInput_AxisNotify(x, y, xoffset, yoffset));
+                                float xoffset,
+                                float yoffset,
+                                uint32_t time_stamp) {
+  ui::WaylandInputEvent event;
+  event.type = ui::WaylandInputEvent::AXIS;
+  event.x = x;
+  event.y = y;
+  event.x_offset = xoffset;
+  event.y_offset = yoffset;
+  event.time_stamp = time_stamp;
+  QueueInputEvent(event);
+}
+
+void WaylandDisplay::ScrollNotify(ui::EventType type,
+                                  float x,
+                                  float y,
+                                  float xoffset,
+                                  float yoffset,
+                                  uint32_t time_stamp) {
+  ui::WaylandInputEvent event;
+  event.type = ui::WaylandInputEvent::SCROLL;
+  event.event_type = type;
+  event.x = x;
+  event.y = y;
+  event.x_offset = xoffset;
+  event.y_offset = yoffset;
+  event.time_stamp = time_stamp;
+  QueueInputEvent(event);
 }
 
 void WaylandDisplay::PointerEnter(unsigned handle, float x, float y) {
-  Dispatch(new WaylandInput_PointerEnter(handle, x, y));
+  ui::WaylandInputEvent event;
+  event.type = ui::WaylandInputEvent::POINTER_ENTER;
+  event.handle = handle;
+  event.x = x;
+  event.y = y;
+  QueueInputEvent(event);
 }
 
 void WaylandDisplay::PointerLeave(unsigned handle, float x, float y) {
-  Dispatch(new WaylandInput_PointerLeave(handle, x, y));
+  ui::WaylandInputEvent event;
+  event.type = ui::WaylandInputEvent::POINTER_LEAVE;
+  event.handle = handle;
+  event.x = x;
+  event.y = y;
+  QueueInputEvent(event);
 }
 
 void WaylandDisplay::KeyNotify(ui::EventType type,
@@ -724,7 +1167,49 @@ void WaylandDisplay::TouchNotify(ui::EventType type,
                                  float y,
                                  int32_t touch_id,
                                  uint32_t time_stamp) {
-  Dispatch(new WaylandInput_TouchNotify(type, x, y, touch_id, time_stamp));
+  ui::WaylandInputEvent event;
+  event.type = ui::WaylandInputEvent::TOUCH;
+  event.event_type = type;
+  event.x = x;
+  event.y = y;
+  event.touch_id = touch_id;
+  event.time_stamp = time_stamp;
+  QueueInputEvent(event);
+}
+
+void WaylandDisplay::FlushInputEvents() {
+  base::AutoLock lock(input_lock_);
+  if (pending_input_events_.empty())
+    return;
+
+  TRACE_EVENT1("ozone", "WaylandDisplay::FlushInputEvents",
+               "events", pending_input_events_.size());
+  UpdateInputBatchStats(pending_input_events_.size());
+  int64_t send_time = base::TimeTicks::Now().ToInternalValue();
+  for (ui::WaylandInputEvent& event : pending_input_events_)
+    event.send_time = send_time;
+
+  // The browser only dispatches records once it has handled the messages
+  // sent before them and dispatches the ones sent before a message first, so
+  // events stay in order with messages and with batches that fell back to
+  // IPC because the ring was full.
+  if (input_ring_active_) {
+    uint32_t sequence;
+    {
+      base::AutoLock lock(dispatch_lock_);
+      sequence = ring_message_count_;
+    }
+    for (ui::WaylandInputEvent& event : pending_input_events_)
+      event.sequence = sequence;
+    if (input_ring_->Write(pending_input_events_)) {
+      pending_input_events_.clear();
+      return;
+    }
+  }
+
+  InputEventList events;
+  events.swap(pending_input_events_);
+  Dispatch(new WaylandInput_EventBatch(events));
 }
 
 void WaylandDisplay::OutputSizeChanged(unsigned width, unsigned height) {
@@ -737,6 +1222,11 @@ void WaylandDisplay::WindowResized(unsigned handle,
   Dispatch(new WaylandWindow_Resized(handle, width, height));
 }
 
+void WaylandDisplay::CanvasBufferReleased(unsigned handle,
+                                          uint32_t buffer_id) {
+  Dispatch(new WaylandWindow_CanvasBufferReleased(handle, buffer_id));
+}
+
 void WaylandDisplay::WindowUnminimized(unsigned handle) {
   Dispatch(new WaylandWindow_Unminimized(handle));
 }
@@ -805,11 +1295,40 @@ void WaylandDisplay::DragDrop(unsigned windowhandle) {
 }
 
 void WaylandDisplay::Dispatch(IPC::Message* message) {
+  // Keep the relative order of batched input events and everything else, i.e.
+  // a key press or a configure event must not overtake a pending click.
+  if (message->type() != WaylandInput_EventBatch::ID &&
+      message->type() != WaylandInput_InputRingCreated::ID) {
+    FlushInputEvents();
+  }
+
+  base::AutoLock lock(dispatch_lock_);
   if (!loop_) {
     deferred_messages_.push(message);
     return;
   }
 
+  DispatchLocked(message);
+}
+
+void WaylandDisplay::DispatchLocked(IPC::Message* message) {
+  dispatch_lock_.AssertAcquired();
+  // Counted before the message can be seen by the browser, which counts the
+  // messages it handles the same way.
+  if (message->type() == WaylandInput_InputRingCreated::ID)
+    ring_message_count_ = 0;
+  else
+    ring_message_count_++;
+
+  TRACE_EVENT1("ozone", "WaylandDisplay::Dispatch",
+               "io_thread", send_from_io_thread_);
+  if (send_from_io_thread_) {
+    // See Send() for why the message is marked as unblocking.
+    message->set_unblock(true);
+    message_filter_->Send(message);
+    return;
+  }
+
   loop_->task_runner()->PostTask(FROM_HERE,
       base::Bind(&WaylandDisplay::Send,
                  weak_ptr_factory_.GetWeakPtr(),
@@ -817,6 +1336,7 @@ void WaylandDisplay::Dispatch(IPC::Message* message) {
 }
 
 void WaylandDisplay::Send(IPC::Message* message) {
+  TRACE_EVENT0("ozone", "WaylandDisplay::Send");
   // The GPU process never sends synchronous IPC, so clear the unblock flag.
   // This ensures the message is treated as a synchronous one and helps preserve
   // order. Check set_unblock in ipc_messages.h for explanation.
@@ -824,5 +1344,128 @@ void WaylandDisplay::Send(IPC::Message* message) {
   sender_->Send(message);
 }
 
+void WaylandDisplay::QueueInputEvent(const ui::WaylandInputEvent& event) {
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::AutoLock lock(input_lock_);
+  pending_input_events_.push_back(event);
+  ui::WaylandInputEvent& queued = pending_input_events_.back();
+  queued.capture_time = now.ToInternalValue();
+  queued.event_time =
+      ProtocolTimeToTimeTicks(event.time_stamp, now).ToInternalValue();
+}
+
+int WaylandDisplay::DispatchPendingEvents() {
+  // Input goes first, so that a burst of configure or data device events
+  // doesn't delay pointer and touch handling.
+  base::TimeTicks start = base::TimeTicks::Now();
+  int input_events = wl_display_dispatch_queue_pending(display_, input_queue_);
+  base::TimeTicks input_done = base::TimeTicks::Now();
+  int default_events = wl_display_dispatch_pending(display_);
+  int frame_events;
+  {
+    base::AutoLock lock(frame_queue_lock_);
+    frame_events = wl_display_dispatch_queue_pending(display_, frame_queue_);
+  }
+  base::TimeTicks done = base::TimeTicks::Now();
+  if (input_events < 0 || default_events < 0 || frame_events < 0)
+    return -1;
+
+  default_events += frame_events;
+
+  UpdateQueueStats(input_events, input_done - start,
+                   default_events, done - input_done);
+  return input_events + default_events;
+}
+
+void WaylandDisplay::CountEventSourceWakeup() {
+  wakeup_count_++;
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (wakeup_stats_period_start_.is_null()) {
+    wakeup_stats_period_start_ = now;
+    return;
+  }
+
+  base::TimeDelta elapsed = now - wakeup_stats_period_start_;
+  if (elapsed < base::TimeDelta::FromSeconds(1))
+    return;
+
+  int wakeups_per_second = wakeup_count_ / elapsed.InSecondsF();
+  TRACE_COUNTER1("ozone", "WaylandEventSourceWakeups", wakeups_per_second);
+  VLOG(1) << "Wayland event source: " << wakeups_per_second
+          << " wakeups/s";
+  wakeup_count_ = 0;
+  wakeup_stats_period_start_ = now;
+}
+
+void WaylandDisplay::UpdateQueueStats(int input_events,
+                                      base::TimeDelta input_time,
+                                      int default_events,
+                                      base::TimeDelta default_time) {
+  input_queue_events_ += input_events;
+  default_queue_events_ += default_events;
+  input_queue_time_ += input_time;
+  default_queue_time_ += default_time;
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (queue_stats_period_start_.is_null()) {
+    queue_stats_period_start_ = now;
+    return;
+  }
+
+  base::TimeDelta elapsed = now - queue_stats_period_start_;
+  if (elapsed < base::TimeDelta::FromSeconds(1))
+    return;
+
+  double seconds = elapsed.InSecondsF();
+  TRACE_COUNTER2("ozone", "WaylandInputQueue",
+                 "events_per_second", input_queue_events_ / seconds,
+                 "busy_us_per_second",
+                 input_queue_time_.InMicroseconds() / seconds);
+  TRACE_COUNTER2("ozone", "WaylandDefaultQueue",
+                 "events_per_second", default_queue_events_ / seconds,
+                 "busy_us_per_second",
+                 default_queue_time_.InMicroseconds() / seconds);
+  VLOG(1) << "Wayland input queue: "
+          << static_cast<int>(input_queue_events_ / seconds) << " events/s, "
+          << input_queue_time_.InMicroseconds() << "us; default queue: "
+          << static_cast<int>(default_queue_events_ / seconds)
+          << " events/s, " << default_queue_time_.InMicroseconds() << "us";
+  input_queue_events_ = 0;
+  default_queue_events_ = 0;
+  input_queue_time_ = base::TimeDelta();
+  default_queue_time_ = base::TimeDelta();
+  queue_stats_period_start_ = now;
+}
+
+void WaylandDisplay::UpdateInputBatchStats(size_t batch_size) {
+  input_event_count_ += batch_size;
+  input_message_count_++;
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (input_stats_period_start_.is_null()) {
+    input_stats_period_start_ = now;
+    return;
+  }
+
+  base::TimeDelta elapsed = now - input_stats_period_start_;
+  if (elapsed < base::TimeDelta::FromSeconds(1))
+    return;
+
+  // Without batching every event would have been a message of its own, so
+  // the two rates show the reduction of IPC messages and browser tasks.
+  double seconds = elapsed.InSecondsF();
+  int events_per_second = input_event_count_ / seconds;
+  int messages_per_second = input_message_count_ / seconds;
+  TRACE_COUNTER2("ozone", "WaylandInputBatching",
+                 "events_per_second", events_per_second,
+                 "messages_per_second", messages_per_second);
+  VLOG(1) << "Wayland input: " << events_per_second << " events/s sent in "
+          << messages_per_second << " messages/s";
+
+  input_event_count_ = 0;
+  input_message_count_ = 0;
+  input_stats_period_start_ = now;
+}
+
 }  // namespace ozonewayland
 
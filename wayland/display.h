@@ -20,13 +20,21 @@
 #include <list>
 #include <map>
 #include <queue>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "ozone/platform/wayland_input_event.h"
 #include "ozone/platform/window_constants.h"
+#include "ozone/wayland/display_poll_thread.h"
 #include "ui/events/event_constants.h"
 #include "ui/ozone/public/gpu_platform_support.h"
 #include "ui/ozone/public/surface_factory_ozone.h"
@@ -34,6 +42,9 @@
 struct gbm_device;
 struct wl_egl_window;
 struct wl_text_input_manager;
+struct wp_presentation;
+struct wp_viewporter;
+struct zwp_linux_dmabuf_v1;
 
 namespace base {
 class MessageLoop;
@@ -45,13 +56,25 @@ class Sender;
 
 namespace ozonewayland {
 
-class WaylandDisplayPollThread;
+// Layout modifier of buffers allocated without an explicit one
+// (DRM_FORMAT_MOD_INVALID).
+const uint64_t kDrmFormatModInvalid = 0x00ffffffffffffffULL;
+
+class WaylandCursorTheme;
+class WaylandDisplayEventWatcher;
+class WaylandDisplayMessageFilter;
+class WaylandFrameClock;
+class WaylandInputRingBuffer;
+class WaylandPixmapPool;
 class WaylandScreen;
 class WaylandSeat;
 class WaylandShell;
 class WaylandWindow;
 
 typedef std::map<unsigned, WaylandWindow*> WindowMap;
+typedef std::map<unsigned, WaylandFrameClock*> FrameClockMap;
+typedef base::Callback<scoped_ptr<ui::SurfaceOzoneCanvas>(
+    gfx::AcceleratedWidget)> CanvasFactory;
 
 // WaylandDisplay is a wrapper around wl_display. Once we get a valid
 // wl_display, the Wayland server will send different events to register
@@ -65,11 +88,29 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   // Ownership is not passed to the caller.
   static WaylandDisplay* GetInstance() { return instance_; }
 
+  // Wayland timestamps are milliseconds with an undefined base. Most
+  // compositors use CLOCK_MONOTONIC, which is also the clock of
+  // base::TimeTicks, so |time_stamp| is converted if it is plausible on that
+  // clock, |now| is returned otherwise.
+  static base::TimeTicks ProtocolTimeToTimeTicks(uint32_t time_stamp,
+                                                 base::TimeTicks now);
+
   // Returns a pointer to wl_display.
   wl_display* display() const { return display_; }
 
   wl_registry* registry() const { return registry_; }
 
+  // Queue of the seat and its input devices. It's dispatched before the
+  // default queue, which carries shell, output and data device events.
+  wl_event_queue* input_queue() const { return input_queue_; }
+  // Queue of frame callbacks and of releases of pixmap buffers, dispatched
+  // after the default queue. Proxies are created on it from the GPU thread
+  // while holding frame_queue_lock(), which is held while the queue is
+  // dispatched, so that no event can be dispatched before its listener has
+  // been added. Proxies destroyed under the lock get no more events.
+  wl_event_queue* frame_queue() const { return frame_queue_; }
+  base::Lock& frame_queue_lock() { return frame_queue_lock_; }
+
   // Warning: Most uses of this function need to be removed in order to fix
   // multiseat. See: https://github.com/01org/ozone-wayland/issues/386
   WaylandSeat* PrimarySeat() const { return primary_seat_; }
@@ -77,12 +118,35 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   // Returns a list of the registered screens.
   const std::list<WaylandScreen*>& GetScreenList() const;
   WaylandScreen* PrimaryScreen() const { return primary_screen_ ; }
+  // Returns the screen wrapping |output|, NULL if there is none.
+  WaylandScreen* GetScreen(wl_output* output) const;
 
   WaylandShell* GetShell() const { return shell_; }
 
   wl_shm* GetShm() const { return shm_; }
   wl_compositor* GetCompositor() const { return compositor_; }
+  uint32_t GetCompositorVersion() const { return compositor_version_; }
+  // NULL if no cursor theme could be loaded.
+  WaylandCursorTheme* GetCursorTheme() const { return cursor_theme_.get(); }
+  // NULL if the compositor doesn't support subsurfaces.
+  wl_subcompositor* GetSubcompositor() const { return subcompositor_; }
+  // NULL if the compositor can't crop and scale surfaces.
+  wp_viewporter* GetViewporter() const { return viewporter_; }
   struct wl_text_input_manager* GetTextInputManager() const;
+  // NULL if the compositor doesn't support presentation-time.
+  wp_presentation* GetPresentation() const { return presentation_; }
+  // Converts a presentation-time timestamp to base::TimeTicks. Returns false
+  // if the compositor's presentation clock isn't the one of base::TimeTicks.
+  bool PresentationTimeToTimeTicks(uint32_t tv_sec_hi,
+                                   uint32_t tv_sec_lo,
+                                   uint32_t tv_nsec,
+                                   base::TimeTicks* time) const;
+  // NULL if the compositor can't import dma-bufs as wl_buffers.
+  zwp_linux_dmabuf_v1* GetLinuxDmabuf() const { return linux_dmabuf_; }
+  // Returns true if the compositor can import dma-bufs with DRM fourcc
+  // |format| and layout |modifier|. The supported formats are collected
+  // during initialization, so this can be called from any thread.
+  bool IsDmabufFormatSupported(uint32_t format, uint64_t modifier) const;
 
   wl_data_device_manager*
   GetDataDeviceManager() const { return data_device_manager_; }
@@ -98,10 +162,26 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   // Destroys WaylandWindow whose handle is w.
   void DestroyWindow(unsigned w);
 
+  // Makes the frame timing statistics of |clock| available to the browser
+  // as those of window |handle|. Called on the GPU main thread, |clock| must
+  // be unregistered before it goes away.
+  void RegisterFrameClock(unsigned handle, WaylandFrameClock* clock);
+  void UnregisterFrameClock(unsigned handle);
+
   // Does a round trip to Wayland server. This call blocks the current thread
   // until all pending request are processed by the server.
   void FlushDisplay();
 
+  // Browser only. Software rendered windows are drawn by the browser and
+  // presented by the GPU process, |factory| creates their canvases.
+  void SetCanvasFactory(const CanvasFactory& factory) {
+    canvas_factory_ = factory;
+  }
+
+  // Must be called before InitializeHardware() to have an effect.
+  void SetPollThreadPolicy(const WaylandPollThreadPolicy& policy) {
+    poll_thread_policy_ = policy;
+  }
   bool InitializeHardware();
 
   // Ozone Display implementation:
@@ -119,17 +199,34 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   scoped_refptr<ui::NativePixmap> CreateNativePixmap(
       gfx::AcceleratedWidget widget, gfx::Size size, gfx::BufferFormat format,
           gfx::BufferUsage usage) override;
+  // Formats of native pixmaps the compositor can import, so that e.g. video
+  // frames can be presented without a color conversion.
+  std::vector<gfx::BufferFormat> GetScanoutFormats(
+      gfx::AcceleratedWidget widget) override;
 
   scoped_ptr<ui::SurfaceOzoneCanvas> CreateCanvasForWidget(
       gfx::AcceleratedWidget widget) override;
 
-  void MotionNotify(float x, float y);
+  void MotionNotify(float x, float y, uint32_t time_stamp);
   void ButtonNotify(unsigned handle,
                     ui::EventType type,
                     ui::EventFlags flags,
                     float x,
-                    float y);
-  void AxisNotify(float x, float y, int xoffset, int yoffset);
+                    float y,
+                    uint32_t time_stamp);
+  void AxisNotify(float x,
+                  float y,
+                  float xoffset,
+                  float yoffset,
+                  uint32_t time_stamp);
+  // |type| is one of ET_SCROLL, ET_SCROLL_FLING_START and
+  // ET_SCROLL_FLING_CANCEL.
+  void ScrollNotify(ui::EventType type,
+                    float x,
+                    float y,
+                    float xoffset,
+                    float yoffset,
+                    uint32_t time_stamp);
   void PointerEnter(unsigned handle, float x, float y);
   void PointerLeave(unsigned handle, float x, float y);
   void KeyNotify(ui::EventType type, unsigned code, int device_id);
@@ -139,6 +236,20 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
                    float y,
                    int32_t touch_id,
                    uint32_t time_stamp);
+  // Sends all pointer and touch events queued since the last call in a single
+  // message. Called at protocol frame boundaries, i.e. on wl_touch.frame and
+  // once per wl_display_dispatch cycle of the poll thread.
+  void FlushInputEvents();
+  // Tells the browser that it can draw into canvas buffer |buffer_id| of
+  // window |handle| again.
+  void CanvasBufferReleased(unsigned handle, uint32_t buffer_id);
+  // Called by the event source every time it wakes up to read events. Reports
+  // the number of wakeups per second.
+  void CountEventSourceWakeup();
+  // Dispatches the events already read from the display, input queue first.
+  // Called by the event source on the thread it reads events on. Returns the
+  // number of dispatched events or -1 on error.
+  int DispatchPendingEvents();
 
   void OutputSizeChanged(unsigned width, unsigned height);
   void WindowResized(unsigned handle, unsigned width, unsigned height);
@@ -175,6 +286,9 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
 
  private:
   typedef std::queue<IPC::Message*> DeferredMessages;
+  // Layout modifiers supported by the compositor, keyed by DRM fourcc.
+  typedef std::map<uint32_t, std::set<uint64_t> > DmabufFormatMap;
+  typedef std::vector<ui::WaylandInputEvent> InputEventList;
   void InitializeDisplay();
   // Creates a WaylandWindow backed by EGL Window and maps it to w. This can be
   // useful for callers to track a particular surface. By default the type of
@@ -186,7 +300,9 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   // Starts polling on display fd. This should be used when one needs to
   // continuously read pending events coming from Wayland compositor and
   // dispatch them. The polling is done completely on a separate thread and
-  // doesn't block the thread from which this is called.
+  // doesn't block the thread from which this is called. With the IO pump
+  // event source this is the GPU IO thread, which is only known once the
+  // message filter has been attached, so this may need to be called again.
   void StartProcessingEvents();
   // Stops polling on display fd.
   void StopProcessingEvents();
@@ -202,10 +318,16 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
                     ui::WidgetType type);
   void MoveWindow(unsigned widget, unsigned parent,
                   ui::WidgetType type, const gfx::Rect& rect);
-  void AddRegion(unsigned widget, int left, int top, int right, int bottom);
-  void SubRegion(unsigned widget, int left, int top, int right, int bottom);
-  void SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                       const gfx::Point& location);
+  void SetRegion(unsigned widget,
+                 const std::vector<gfx::Rect>& opaque_region,
+                 const std::vector<gfx::Rect>& input_region);
+  void RegisterCursor(uint32_t id,
+                      const std::vector<SkBitmap>& bitmaps,
+                      const gfx::Point& hotspot,
+                      int frame_delay_ms);
+  void SetCursor(uint32_t id);
+  void EvictCursor(uint32_t id);
+  void SetCursorType(ui::WaylandCursorType type);
   void MoveCursor(const gfx::Point& location);
   void ResetIme();
   void ImeCaretBoundsChanged(gfx::Rect rect);
@@ -215,6 +337,16 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   void RequestSelectionData(const std::string& mime_type);
   void DragWillBeAccepted(uint32_t serial, const std::string& mime_type);
   void DragWillBeRejected(uint32_t serial);
+  void GetFrameTimingStats(unsigned handle);
+  void CanvasBuffersCreated(unsigned handle,
+                            base::FileDescriptor shm,
+                            const gfx::Size& size,
+                            uint32_t count,
+                            uint32_t first_id);
+  void CanvasPresent(unsigned handle,
+                     uint32_t buffer_id,
+                     const gfx::Rect& damage);
+  void CanvasDestroyed(unsigned handle);
   // This handler resolves all server events used in initialization. It also
   // handles input device registration, screen registration.
   static void DisplayHandleGlobal(
@@ -223,39 +355,131 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
       uint32_t name,
       const char *interface,
       uint32_t version);
+  static void PresentationClockId(void* data,
+                                  struct wp_presentation* presentation,
+                                  uint32_t clk_id);
+  static void DmabufFormat(void* data,
+                           struct zwp_linux_dmabuf_v1* linux_dmabuf,
+                           uint32_t format);
+  static void DmabufModifier(void* data,
+                             struct zwp_linux_dmabuf_v1* linux_dmabuf,
+                             uint32_t format,
+                             uint32_t modifier_hi,
+                             uint32_t modifier_lo);
 
   // GpuPlatformSupport:
   void OnChannelEstablished(IPC::Sender* sender) override;
   bool OnMessageReceived(const IPC::Message& message) override;
   IPC::MessageFilter* GetMessageFilter() override;
-  // Posts task to main loop of the thread on which Dispatcher was initialized.
+  // Sends |message| to the browser. Can be called from any thread, messages
+  // keep their order. Goes straight to the IO thread through
+  // |message_filter_| if it was added to the channel, otherwise posts a task
+  // to the thread on which the channel was established.
   void Dispatch(IPC::Message* message);
+  // Sends |message| on the established channel.
+  void DispatchLocked(IPC::Message* message);
   void Send(IPC::Message* message);
+  void QueueInputEvent(const ui::WaylandInputEvent& event);
+  void UpdateInputBatchStats(size_t batch_size);
+  // Tells the browser which buffers can be shown as overlay planes.
+  void SendOverlayCapabilities();
+  void UpdateQueueStats(int input_events,
+                        base::TimeDelta input_time,
+                        int default_events,
+                        base::TimeDelta default_time);
 
   // WaylandDisplay manages the memory of all these pointers.
   wl_display* display_;
   wl_registry* registry_;
+  wl_event_queue* input_queue_;
+  wl_event_queue* frame_queue_;
   wl_compositor* compositor_;
+  uint32_t compositor_version_;
+  wl_subcompositor* subcompositor_;
+  wp_viewporter* viewporter_;
   wl_data_device_manager* data_device_manager_;
   WaylandShell* shell_;
   wl_shm* shm_;
+  // Created along with |shm_|, shared by the cursors of all seats.
+  scoped_ptr<WaylandCursorTheme> cursor_theme_;
   struct wl_text_input_manager* text_input_manager_;
+  wp_presentation* presentation_;
+  zwp_linux_dmabuf_v1* linux_dmabuf_;
   WaylandScreen* primary_screen_;
   WaylandSeat* primary_seat_;
   WaylandDisplayPollThread* display_poll_thread_;
+  // Only created with OZONE_WAYLAND_EVENT_SOURCE=io_pump, in which case it is
+  // used instead of |display_poll_thread_|.
+  WaylandDisplayEventWatcher* display_event_watcher_;
+  WaylandPollThreadPolicy poll_thread_policy_;
+  CanvasFactory canvas_factory_;
   gbm_device* device_;
+#if defined(ENABLE_DRM_SUPPORT)
+  // Recycles the buffers of native pixmaps, created along with |device_|.
+  scoped_refptr<WaylandPixmapPool> pixmap_pool_;
+#endif
   char* m_deviceName;
   IPC::Sender* sender_;
   base::MessageLoop* loop_;
+  scoped_refptr<WaylandDisplayMessageFilter> message_filter_;
+  // Set once |message_filter_| has been handed out to be added to the channel.
+  bool message_filter_added_;
+  // Set in OnChannelEstablished if |message_filter_| was added, unless
+  // OZONE_WAYLAND_SEND_ON_MAIN_THREAD is set. Fixed for the lifetime of the
+  // channel so that messages can't overtake each other by taking different
+  // routes.
+  bool send_from_io_thread_;
 
   std::list<WaylandScreen*> screen_list_;
   std::list<WaylandSeat*> seat_list_;
   WindowMap widget_map_;
+  FrameClockMap frame_clocks_;
+  // Only written during InitializeDisplay.
+  DmabufFormatMap dmabuf_formats_;
+  // Guards |loop_|, |sender_|, |deferred_messages_| and
+  // |ring_message_count_|. Messages are dispatched from the poll thread as
+  // well as the GPU main thread.
+  base::Lock dispatch_lock_;
   // Display queues messages till Channel is establised.
   DeferredMessages deferred_messages_;
+  // Messages sent since WaylandInput_InputRingCreated, stamped on the events
+  // written to |input_ring_|.
+  uint32_t ring_message_count_;
+  // Held while |frame_queue_| is dispatched, see frame_queue().
+  base::Lock frame_queue_lock_;
+  // Guards |pending_input_events_| and the producer side of |input_ring_|.
+  // Input events are queued on the poll thread, but any Dispatch() from the
+  // GPU main thread may flush them.
+  base::Lock input_lock_;
+  // Pointer and touch events waiting for the end of the current frame.
+  InputEventList pending_input_events_;
+  // Shared memory transport for input events, only created when
+  // OZONE_WAYLAND_INPUT_RING_BUFFER is set. It's allocated before the sandbox
+  // is engaged and used once the browser has been told about it.
+  scoped_ptr<WaylandInputRingBuffer> input_ring_;
+  bool input_ring_active_;
+  // Number of input events and batch messages sent since
+  // |input_stats_period_start_|, used to report the batching ratio.
+  unsigned input_event_count_;
+  unsigned input_message_count_;
+  base::TimeTicks input_stats_period_start_;
+  // Events dispatched from, and time spent on, each queue since
+  // |queue_stats_period_start_|.
+  unsigned input_queue_events_;
+  unsigned default_queue_events_;
+  base::TimeDelta input_queue_time_;
+  base::TimeDelta default_queue_time_;
+  base::TimeTicks queue_stats_period_start_;
+  // Event source wakeups since |wakeup_stats_period_start_|.
+  unsigned wakeup_count_;
+  base::TimeTicks wakeup_stats_period_start_;
   unsigned serial_;
   bool processing_events_ :1;
   bool m_authenticated_ :1;
+  // Set on the thread dispatching Wayland events, which is also the one
+  // reading it. Not a bitfield, the other flags are written on the GPU main
+  // thread and would share its memory location.
+  bool presentation_clock_is_monotonic_;
   int m_fd_;
   uint32_t m_capabilities_;
   static WaylandDisplay* instance_;
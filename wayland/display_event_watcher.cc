@@ -0,0 +1,148 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/display_event_watcher.h"
+
+#include <errno.h>
+#include <wayland-client.h>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/wayland/display.h"
+
+namespace ozonewayland {
+
+WaylandDisplayEventWatcher::WaylandDisplayEventWatcher(wl_display* display)
+    : display_(display),
+      watching_(false),
+      waiting_for_write_(false) {
+  DCHECK(display_);
+}
+
+WaylandDisplayEventWatcher::~WaylandDisplayEventWatcher() {
+  StopProcessingEvents();
+}
+
+void WaylandDisplayEventWatcher::StartProcessingEvents(
+    scoped_refptr<base::SingleThreadTaskRunner> io_task_runner) {
+  DCHECK(!io_task_runner_);
+  io_task_runner_ = io_task_runner;
+  io_task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&WaylandDisplayEventWatcher::StartOnIOThread,
+                 base::Unretained(this)));
+}
+
+void WaylandDisplayEventWatcher::StopProcessingEvents() {
+  if (!io_task_runner_)
+    return;
+
+  DCHECK(!io_task_runner_->BelongsToCurrentThread());
+  base::WaitableEvent stopped(true, false);
+  if (io_task_runner_->PostTask(
+          FROM_HERE,
+          base::Bind(&WaylandDisplayEventWatcher::StopOnIOThread,
+                     base::Unretained(this), &stopped))) {
+    stopped.Wait();
+  }
+
+  io_task_runner_ = NULL;
+}
+
+void WaylandDisplayEventWatcher::OnFileCanReadWithoutBlocking(int fd) {
+  DispatchEvents();
+}
+
+void WaylandDisplayEventWatcher::OnFileCanWriteWithoutBlocking(int fd) {
+  waiting_for_write_ = false;
+  Watch(base::MessageLoopForIO::WATCH_READ);
+  Flush();
+}
+
+void WaylandDisplayEventWatcher::WillProcessTask(
+    const base::PendingTask& pending_task) {
+}
+
+void WaylandDisplayEventWatcher::DidProcessTask(
+    const base::PendingTask& pending_task) {
+  Flush();
+}
+
+void WaylandDisplayEventWatcher::StartOnIOThread() {
+  watching_ = true;
+  Watch(base::MessageLoopForIO::WATCH_READ);
+  base::MessageLoop::current()->AddTaskObserver(this);
+  // Events may have been read into the queue before we started watching,
+  // e.g. by a roundtrip during initialization.
+  WaylandDisplay::GetInstance()->DispatchPendingEvents();
+  WaylandDisplay::GetInstance()->FlushInputEvents();
+  Flush();
+}
+
+void WaylandDisplayEventWatcher::StopOnIOThread(base::WaitableEvent* stopped) {
+  if (watching_) {
+    base::MessageLoop::current()->RemoveTaskObserver(this);
+    controller_.StopWatchingFileDescriptor();
+    watching_ = false;
+  }
+
+  stopped->Signal();
+}
+
+void WaylandDisplayEventWatcher::DispatchEvents() {
+  TRACE_EVENT0("ozone", "WaylandDisplayEventWatcher::DispatchEvents");
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  display->CountEventSourceWakeup();
+  while (wl_display_prepare_read(display_) != 0) {
+    if (display->DispatchPendingEvents() < 0) {
+      StopOnError();
+      return;
+    }
+  }
+
+  if (wl_display_read_events(display_) < 0 && errno != EAGAIN) {
+    StopOnError();
+    return;
+  }
+
+  if (display->DispatchPendingEvents() < 0) {
+    StopOnError();
+    return;
+  }
+
+  // Everything read belongs to the same frame, send the input events collected
+  // meanwhile as one batch.
+  display->FlushInputEvents();
+  Flush();
+}
+
+void WaylandDisplayEventWatcher::StopOnError() {
+  LOG(ERROR) << "Dispatching Wayland events failed with an error." << errno
+             << " Protocol error: " << wl_display_get_error(display_);
+  base::MessageLoop::current()->RemoveTaskObserver(this);
+  controller_.StopWatchingFileDescriptor();
+  watching_ = false;
+}
+
+void WaylandDisplayEventWatcher::Flush() {
+  if (!watching_ || waiting_for_write_)
+    return;
+
+  if (wl_display_flush(display_) < 0 && errno == EAGAIN) {
+    waiting_for_write_ = true;
+    Watch(base::MessageLoopForIO::WATCH_READ_WRITE);
+  }
+}
+
+void WaylandDisplayEventWatcher::Watch(base::MessageLoopForIO::Mode mode) {
+  controller_.StopWatchingFileDescriptor();
+  base::MessageLoopForIO::current()->WatchFileDescriptor(
+      wl_display_get_fd(display_), true, mode, &controller_, this);
+}
+
+}  // namespace ozonewayland
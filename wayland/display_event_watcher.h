@@ -0,0 +1,72 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_DISPLAY_EVENT_WATCHER_H_
+#define OZONE_WAYLAND_DISPLAY_EVENT_WATCHER_H_
+
+#include "base/memory/ref_counted.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_pump_libevent.h"
+
+struct wl_display;
+
+namespace base {
+class SingleThreadTaskRunner;
+class WaitableEvent;
+}
+
+namespace ozonewayland {
+
+// Alternative to WaylandDisplayPollThread, selected with
+// OZONE_WAYLAND_EVENT_SOURCE=io_pump. Instead of blocking in poll() on a
+// thread of its own, it watches the display fd from an existing IO message
+// loop and reads events with wl_display_prepare_read/wl_display_read_events
+// when the fd is readable. Requests are flushed once at the end of every task
+// run by that loop rather than after every wakeup.
+class WaylandDisplayEventWatcher : public base::MessagePumpLibevent::Watcher,
+                                   public base::MessageLoop::TaskObserver {
+ public:
+  explicit WaylandDisplayEventWatcher(wl_display* display);
+  ~WaylandDisplayEventWatcher() override;
+
+  // Starts watching on the thread of |io_task_runner|, which must run a
+  // base::MessageLoopForIO.
+  void StartProcessingEvents(
+      scoped_refptr<base::SingleThreadTaskRunner> io_task_runner);
+  // Stops watching. Blocks until the IO thread has stopped dispatching, so
+  // must not be called from that thread.
+  void StopProcessingEvents();
+
+  // base::MessagePumpLibevent::Watcher:
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
+  // base::MessageLoop::TaskObserver:
+  void WillProcessTask(const base::PendingTask& pending_task) override;
+  void DidProcessTask(const base::PendingTask& pending_task) override;
+
+ private:
+  void StartOnIOThread();
+  void StopOnIOThread(base::WaitableEvent* stopped);
+  void DispatchEvents();
+  // Stops watching after the connection failed, like the poll thread does.
+  void StopOnError();
+  // Flushes pending requests. If the socket is full, waits for it to become
+  // writable before trying again.
+  void Flush();
+  void Watch(base::MessageLoopForIO::Mode mode);
+
+  wl_display* display_;
+  scoped_refptr<base::SingleThreadTaskRunner> io_task_runner_;
+  // Only used on the IO thread.
+  base::MessagePumpLibevent::FileDescriptorWatcher controller_;
+  bool watching_;
+  bool waiting_for_write_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandDisplayEventWatcher);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_DISPLAY_EVENT_WATCHER_H_
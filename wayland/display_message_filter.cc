@@ -0,0 +1,105 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/display_message_filter.h"
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/location.h"
+#include "base/single_thread_task_runner.h"
+#include "base/thread_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
+#include "ipc/ipc_message.h"
+#include "ipc/ipc_sender.h"
+
+namespace ozonewayland {
+
+WaylandDisplayMessageFilter::WaylandDisplayMessageFilter()
+    : sender_(NULL),
+      closed_(false) {
+}
+
+WaylandDisplayMessageFilter::~WaylandDisplayMessageFilter() {
+  DropPendingMessages();
+}
+
+void WaylandDisplayMessageFilter::Send(IPC::Message* message) {
+  base::AutoLock lock(lock_);
+  if (closed_) {
+    delete message;
+    return;
+  }
+
+  if (!io_task_runner_) {
+    pending_messages_.push(message);
+    return;
+  }
+
+  TRACE_EVENT_FLOW_BEGIN0("ozone", "WaylandDisplayMessageFilter::Send",
+                          message);
+  io_task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&WaylandDisplayMessageFilter::SendOnIOThread, this, message));
+}
+
+scoped_refptr<base::SingleThreadTaskRunner>
+WaylandDisplayMessageFilter::io_task_runner() {
+  base::AutoLock lock(lock_);
+  return io_task_runner_;
+}
+
+void WaylandDisplayMessageFilter::SetAttachedCallback(
+    const AttachedCallback& callback) {
+  base::AutoLock lock(lock_);
+  attached_callback_ = callback;
+  if (io_task_runner_ && !attached_callback_.is_null())
+    base::ResetAndReturn(&attached_callback_).Run(io_task_runner_);
+}
+
+void WaylandDisplayMessageFilter::OnFilterAdded(IPC::Sender* sender) {
+  sender_ = sender;
+  base::AutoLock lock(lock_);
+  // Messages held back so far go out before any message passed to Send() from
+  // now on, which is posted to this thread.
+  while (!pending_messages_.empty()) {
+    sender_->Send(pending_messages_.front());
+    pending_messages_.pop();
+  }
+
+  io_task_runner_ = base::ThreadTaskRunnerHandle::Get();
+  if (!attached_callback_.is_null())
+    base::ResetAndReturn(&attached_callback_).Run(io_task_runner_);
+}
+
+void WaylandDisplayMessageFilter::OnFilterRemoved() {
+  OnChannelClosing();
+}
+
+void WaylandDisplayMessageFilter::OnChannelClosing() {
+  sender_ = NULL;
+  base::AutoLock lock(lock_);
+  io_task_runner_ = NULL;
+  closed_ = true;
+  DropPendingMessages();
+}
+
+void WaylandDisplayMessageFilter::DropPendingMessages() {
+  while (!pending_messages_.empty()) {
+    delete pending_messages_.front();
+    pending_messages_.pop();
+  }
+}
+
+void WaylandDisplayMessageFilter::SendOnIOThread(IPC::Message* message) {
+  TRACE_EVENT_FLOW_END0("ozone", "WaylandDisplayMessageFilter::Send", message);
+  TRACE_EVENT0("ozone", "WaylandDisplayMessageFilter::SendOnIOThread");
+  if (!sender_) {
+    delete message;
+    return;
+  }
+
+  sender_->Send(message);
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,71 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_DISPLAY_MESSAGE_FILTER_H_
+#define OZONE_WAYLAND_DISPLAY_MESSAGE_FILTER_H_
+
+#include <queue>
+
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "ipc/message_filter.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+}
+
+namespace ozonewayland {
+
+// Installed on the GPU process channel to the browser. It owns the channel
+// sender on the IO thread, which lets WaylandDisplay send messages from the
+// Wayland poll thread without going through the GPU main thread.
+class WaylandDisplayMessageFilter : public IPC::MessageFilter {
+ public:
+  typedef base::Callback<void(scoped_refptr<base::SingleThreadTaskRunner>)>
+      AttachedCallback;
+
+  WaylandDisplayMessageFilter();
+
+  // Can be called from any thread. Takes ownership of |message| and sends it
+  // from the IO thread. Messages keep the order in which they were passed.
+  // Messages passed before the filter is attached are held back until then,
+  // messages passed after the channel closed are dropped.
+  void Send(IPC::Message* message);
+  // Task runner of the IO thread the channel lives on, NULL while the filter
+  // is not attached.
+  scoped_refptr<base::SingleThreadTaskRunner> io_task_runner();
+  // Runs |callback| with the IO task runner once the filter is attached, or
+  // right away if it already is. The callback runs under the lock of the
+  // filter, so once SetAttachedCallback() returned after being passed a null
+  // callback, the previous one won't run anymore.
+  void SetAttachedCallback(const AttachedCallback& callback);
+
+  // IPC::MessageFilter:
+  void OnFilterAdded(IPC::Sender* sender) override;
+  void OnFilterRemoved() override;
+  void OnChannelClosing() override;
+
+ private:
+  ~WaylandDisplayMessageFilter() override;
+  void SendOnIOThread(IPC::Message* message);
+  void DropPendingMessages();
+
+  // Only used on the IO thread.
+  IPC::Sender* sender_;
+  // Guards the members below. |io_task_runner_| is set while the filter is
+  // attached.
+  base::Lock lock_;
+  scoped_refptr<base::SingleThreadTaskRunner> io_task_runner_;
+  // Messages passed to Send() before the filter was attached.
+  std::queue<IPC::Message*> pending_messages_;
+  AttachedCallback attached_callback_;
+  bool closed_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandDisplayMessageFilter);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_DISPLAY_MESSAGE_FILTER_H_
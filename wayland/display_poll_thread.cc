@@ -7,21 +7,78 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <wayland-client.h>
 
+#include <vector>
+
 #include "base/bind.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
 #include "ozone/wayland/display.h"
 
 namespace ozonewayland {
 const int MAX_EVENTS = 16;
 
-WaylandDisplayPollThread::WaylandDisplayPollThread(wl_display* display)
+WaylandPollThreadPolicy::WaylandPollThreadPolicy()
+    : priority(base::ThreadPriority::BACKGROUND),
+      fifo(false),
+      cpu_affinity(0) {
+}
+
+// static
+bool WaylandPollThreadPolicy::FromString(const std::string& value,
+                                         WaylandPollThreadPolicy* policy) {
+  std::vector<std::string> parts = base::SplitString(
+      value, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  if (parts.empty())
+    return false;
+
+  WaylandPollThreadPolicy result;
+  if (parts[0] == "background")
+    result.priority = base::ThreadPriority::BACKGROUND;
+  else if (parts[0] == "normal")
+    result.priority = base::ThreadPriority::NORMAL;
+  else if (parts[0] == "display")
+    result.priority = base::ThreadPriority::DISPLAY;
+  else if (parts[0] == "realtime")
+    result.priority = base::ThreadPriority::REALTIME_AUDIO;
+  else
+    return false;
+
+  const std::string kCpusPrefix = "cpus=";
+  for (size_t i = 1; i < parts.size(); ++i) {
+    if (parts[i] == "fifo") {
+      result.fifo = true;
+    } else if (parts[i].compare(0, kCpusPrefix.size(), kCpusPrefix) == 0) {
+      if (!base::HexStringToUInt64(parts[i].substr(kCpusPrefix.size()),
+                                   &result.cpu_affinity)) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  *policy = result;
+  return true;
+}
+
+WaylandDisplayPollThread::WaylandDisplayPollThread(
+    wl_display* display,
+    const WaylandPollThreadPolicy& policy)
     : base::Thread("WaylandDisplayPollThread"),
-      display_(display),
       polling_(true, false),
-      stop_polling_(true, false) {
+      stop_polling_(true, false),
+      display_(display),
+      policy_(policy) {
   DCHECK(display_);
 }
 
@@ -33,7 +90,7 @@ void WaylandDisplayPollThread::StartProcessingEvents() {
   DCHECK(!polling_.IsSignaled());
   base::Thread::Options options;
   options.message_loop_type = base::MessageLoop::TYPE_IO;
-  options.priority = base::ThreadPriority::BACKGROUND;
+  options.priority = policy_.priority;
   StartWithOptions(options);
   task_runner()->PostTask(FROM_HERE, base::Bind(
       &WaylandDisplayPollThread::DisplayRun, this));
@@ -50,6 +107,30 @@ void WaylandDisplayPollThread::CleanUp() {
   SetThreadWasQuitProperly(true);
 }
 
+void WaylandDisplayPollThread::ApplySchedulingPolicy() {
+  if (policy_.fifo) {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error)
+      LOG(WARNING) << "Failed to use SCHED_FIFO for the poll thread: "
+                   << strerror(error);
+  }
+
+  if (policy_.cpu_affinity) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (policy_.cpu_affinity & (1ULL << cpu))
+        CPU_SET(cpu, &cpus);
+    }
+
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0)
+      PLOG(WARNING) << "Failed to set the CPU affinity of the poll thread";
+  }
+}
+
 void  WaylandDisplayPollThread::DisplayRun(WaylandDisplayPollThread* data) {
   struct pollfd pollfd;
   int i, ret, count = 0;
@@ -57,6 +138,7 @@ void  WaylandDisplayPollThread::DisplayRun(WaylandDisplayPollThread* data) {
   unsigned display_fd = wl_display_get_fd(data->display_);
   pollfd.fd = display_fd;
   pollfd.events = POLLIN | POLLERR | POLLHUP;
+  data->ApplySchedulingPolicy();
 
   // Set the signal state. This is used to query from other threads (i.e.
   // StopProcessingEvents on Main thread), if this thread is still polling.
@@ -65,7 +147,10 @@ void  WaylandDisplayPollThread::DisplayRun(WaylandDisplayPollThread* data) {
   // Adopted from:
   // http://cgit.freedesktop.org/wayland/weston/tree/clients/window.c#n5531.
   while (1) {
-    wl_display_dispatch_pending(data->display_);
+    WaylandDisplay::GetInstance()->DispatchPendingEvents();
+    // Everything read by the last dispatch belongs to the same frame, send the
+    // input events collected meanwhile as one batch.
+    WaylandDisplay::GetInstance()->FlushInputEvents();
     ret = wl_display_flush(data->display_);
     if (ret < 0 && errno != EAGAIN) {
       break;
@@ -82,6 +167,7 @@ void  WaylandDisplayPollThread::DisplayRun(WaylandDisplayPollThread* data) {
     }
 
     if (count == 1) {
+      WaylandDisplay::GetInstance()->CountEventSourceWakeup();
       event = pollfd.revents;
       // We can have cases where POLLIN and POLLHUP are both set for
       // example. Don't break if both flags are set.
@@ -91,11 +177,31 @@ void  WaylandDisplayPollThread::DisplayRun(WaylandDisplayPollThread* data) {
       }
 
       if (event & POLLIN) {
-        ret = wl_display_dispatch(data->display_);
+        // Time from poll() returning until the events have been handled, i.e.
+        // how long the thread took to get through them once woken up.
+        base::TimeTicks poll_returned = base::TimeTicks::Now();
+        {
+          TRACE_EVENT0("ozone", "WaylandDisplayPollThread::Dispatch");
+          // wl_display_dispatch() would only dispatch the default queue.
+          // Reading can be skipped if the default queue isn't empty, the
+          // events are dispatched now and the fd polled again afterwards.
+          ret = 0;
+          if (wl_display_prepare_read(data->display_) == 0)
+            ret = wl_display_read_events(data->display_);
+          if (ret != -1)
+            ret = WaylandDisplay::GetInstance()->DispatchPendingEvents();
+        }
         if (ret == -1) {
-          LOG(ERROR) << "wl_display_dispatch failed with an error." << errno;
+          LOG(ERROR) << "Dispatching Wayland events failed with an error."
+                     << errno;
           break;
         }
+
+        base::TimeDelta delay = base::TimeTicks::Now() - poll_returned;
+        UMA_HISTOGRAM_CUSTOM_COUNTS("Ozone.Wayland.PollThreadDispatchDelay",
+                                    delay.InMicroseconds(), 1, 1000000, 50);
+        TRACE_COUNTER1("ozone", "WaylandPollThreadDispatchDelayUs",
+                       delay.InMicroseconds());
       }
     }
   }
@@ -5,18 +5,41 @@
 #ifndef OZONE_WAYLAND_DISPLAY_POLL_THREAD_H_
 #define OZONE_WAYLAND_DISPLAY_POLL_THREAD_H_
 
+#include <string>
+
 #include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
 
 class wl_display;
 namespace ozonewayland {
+
+// Scheduling settings of the poll thread, which reads all input and configure
+// events and therefore should not be starved by other GPU process threads.
+struct WaylandPollThreadPolicy {
+  WaylandPollThreadPolicy();
+
+  // Parses "<priority>[,fifo][,cpus=<hex mask>]", where priority is one of
+  // background, normal, display or realtime. Returns false if |value| is
+  // malformed, |policy| is left unchanged in that case.
+  static bool FromString(const std::string& value,
+                         WaylandPollThreadPolicy* policy);
+
+  base::ThreadPriority priority;
+  // Run with SCHED_FIFO instead of the default time sharing policy.
+  bool fifo;
+  // Bit n allows the thread to run on CPU n, 0 leaves the affinity alone.
+  uint64_t cpu_affinity;
+};
+
 // This class lets you poll on a given Wayland display (passed in constructor),
 // read any pending events coming from Wayland compositor and dispatch them.
 // Caller should ensure that StopProcessingEvents is called before display is
 // destroyed.
 class WaylandDisplayPollThread : public base::Thread {
  public:
-  explicit WaylandDisplayPollThread(wl_display* display);
+  WaylandDisplayPollThread(wl_display* display,
+                           const WaylandPollThreadPolicy& policy);
   ~WaylandDisplayPollThread() override;
 
   // Starts polling on wl_display fd and read/flush requests coming from Wayland
@@ -30,9 +53,13 @@ class WaylandDisplayPollThread : public base::Thread {
 
  private:
   static void DisplayRun(WaylandDisplayPollThread* data);
+  // Applies the parts of |policy_| base::Thread doesn't handle. Runs on the
+  // poll thread.
+  void ApplySchedulingPolicy();
   base::WaitableEvent polling_;  // Is set as long as the thread is polling.
   base::WaitableEvent stop_polling_;
   wl_display* display_;
+  WaylandPollThreadPolicy policy_;
   DISALLOW_COPY_AND_ASSIGN(WaylandDisplayPollThread);
 };
 
@@ -4,17 +4,83 @@
 
 #include "ozone/wayland/egl/surface_ozone_wayland.h"
 
+#include <EGL/egl.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/thread_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
 #include "ozone/wayland/display.h"
+#include "ozone/wayland/egl/wayland_frame_clock.h"
+#include "ozone/wayland/egl/wayland_vsync_provider.h"
+#include "ozone/wayland/shell/shell_surface.h"
 #include "ozone/wayland/window.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/swap_result.h"
 #include "ui/gfx/vsync_provider.h"
 
 namespace ozonewayland {
 
+namespace {
+
+// Number of swapped frames the compositor may lag behind before swaps are
+// throttled. Can be changed with OZONE_WAYLAND_MAX_PENDING_FRAMES.
+const size_t kDefaultMaxPendingFrames = 2;
+
+size_t GetMaxPendingFrames() {
+  const char* value = getenv("OZONE_WAYLAND_MAX_PENDING_FRAMES");
+  int max_pending_frames = value ? atoi(value) : 0;
+  return max_pending_frames > 0 ? max_pending_frames
+                                : kDefaultMaxPendingFrames;
+}
+
+// Whether the config of |egl_surface| can preserve the back buffer.
+bool CanPreserveBackBuffer(void* egl_display, void* egl_surface) {
+  EGLint config_id = 0;
+  if (!eglQuerySurface(egl_display, egl_surface, EGL_CONFIG_ID, &config_id))
+    return false;
+
+  const EGLint attribs[] = { EGL_CONFIG_ID, config_id, EGL_NONE };
+  EGLConfig config;
+  EGLint num_configs = 0;
+  EGLint surface_type = 0;
+  return eglChooseConfig(egl_display, attribs, &config, 1, &num_configs) &&
+         num_configs == 1 &&
+         eglGetConfigAttrib(egl_display, config, EGL_SURFACE_TYPE,
+                            &surface_type) &&
+         (surface_type & EGL_SWAP_BEHAVIOR_PRESERVED_BIT);
+}
+
+bool HasEGLExtension(const char* extensions, const char* name) {
+  if (!extensions)
+    return false;
+
+  std::string padded = std::string(" ") + extensions + " ";
+  return padded.find(std::string(" ") + name + " ") != std::string::npos;
+}
+
+}  // namespace
+
 SurfaceOzoneWayland::SurfaceOzoneWayland(unsigned handle)
-    : handle_(handle) {
+    : handle_(handle),
+      frame_clock_(new WaylandFrameClock(GetMaxPendingFrames())),
+      partial_swap_surface_(NULL),
+      swap_buffers_with_damage_(NULL),
+      damaged_pixels_(0),
+      window_pixels_(0),
+      posted_damage_pixels_(-1) {
+  WaylandDisplay::GetInstance()->RegisterFrameClock(handle_,
+                                                    frame_clock_.get());
 }
 
 SurfaceOzoneWayland::~SurfaceOzoneWayland() {
+  WaylandDisplay::GetInstance()->UnregisterFrameClock(handle_);
+  frame_clock_->Shutdown();
   WaylandDisplay::GetInstance()->DestroyWindow(handle_);
   WaylandDisplay::GetInstance()->FlushDisplay();
 }
@@ -31,16 +97,136 @@ bool SurfaceOzoneWayland::ResizeNativeWindow(
   return true;
 }
 
+void SurfaceOzoneWayland::WillSwapBuffers() {
+  WaylandWindow* window = WaylandDisplay::GetInstance()->GetWindow(handle_);
+  if (!window || !window->ShellSurface())
+    return;
+
+  // The planes are synchronized subsurfaces, their state is applied with the
+  // commit of the window surface that eglSwapBuffers makes, so they have to
+  // be committed before it to show up with this frame.
+  window->CommitOverlayPlanes();
+  frame_clock_->RequestFrame(window->ShellSurface()->GetWLSurface());
+}
+
 bool SurfaceOzoneWayland::OnSwapBuffers() {
+  // Synchronous swaps aren't throttled here, waiting for a surface which
+  // isn't shown would stall the GPU thread. eglSwapBuffers waits for the
+  // compositor itself with a swap interval of 1.
+  FinishSwap(base::Closure());
   return true;
 }
 
 void SurfaceOzoneWayland::OnSwapBuffersAsync(
     const ui::SwapCompletionCallback& callback) {
+  FinishSwap(base::Bind(callback, gfx::SwapResult::SWAP_ACK));
 }
 
 scoped_ptr<gfx::VSyncProvider> SurfaceOzoneWayland::CreateVSyncProvider() {
-  return scoped_ptr<gfx::VSyncProvider>();
+  return make_scoped_ptr<gfx::VSyncProvider>(
+      new WaylandVSyncProvider(handle_, frame_clock_));
+}
+
+bool SurfaceOzoneWayland::InitializePostSubBuffer(void* egl_display,
+                                                  void* egl_surface) {
+  partial_swap_surface_ = egl_surface;
+  swap_buffers_with_damage_ = NULL;
+  // Preserving the back buffer makes EGL copy the previous frame into it on
+  // every swap, full swaps included, which can cost more than redrawing only
+  // the damage saves. Opt in where that pays off.
+  if (!getenv("OZONE_WAYLAND_PARTIAL_SWAP"))
+    return false;
+
+  const char* extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+  const char* proc_name = NULL;
+  if (HasEGLExtension(extensions, "EGL_KHR_swap_buffers_with_damage"))
+    proc_name = "eglSwapBuffersWithDamageKHR";
+  else if (HasEGLExtension(extensions, "EGL_EXT_swap_buffers_with_damage"))
+    proc_name = "eglSwapBuffersWithDamageEXT";
+
+  if (!proc_name)
+    return false;
+
+  // Only the damage is redrawn for a partial swap, the rest of the back
+  // buffer has to be the previous frame.
+  if (!CanPreserveBackBuffer(egl_display, egl_surface) ||
+      !eglSurfaceAttrib(egl_display, egl_surface, EGL_SWAP_BEHAVIOR,
+                        EGL_BUFFER_PRESERVED)) {
+    VLOG(1) << "Partial swap disabled, the EGL config doesn't preserve the "
+               "back buffer.";
+    return false;
+  }
+
+  swap_buffers_with_damage_ = reinterpret_cast<SwapBuffersWithDamageProc>(
+      eglGetProcAddress(proc_name));
+  return swap_buffers_with_damage_ != NULL;
+}
+
+bool SurfaceOzoneWayland::OnPostSubBuffer(void* egl_display,
+                                          void* egl_surface,
+                                          int x,
+                                          int y,
+                                          int width,
+                                          int height) {
+  posted_damage_pixels_ = -1;
+  if (egl_surface != partial_swap_surface_ || !swap_buffers_with_damage_)
+    return eglSwapBuffers(egl_display, egl_surface);
+
+  EGLint surface_width = 0;
+  EGLint surface_height = 0;
+  eglQuerySurface(egl_display, egl_surface, EGL_WIDTH, &surface_width);
+  eglQuerySurface(egl_display, egl_surface, EGL_HEIGHT, &surface_height);
+  gfx::Rect damage = gfx::IntersectRects(
+      gfx::Rect(x, y, width, height),
+      gfx::Rect(surface_width, surface_height));
+  // No rects would damage the whole surface as well, so do a full swap.
+  if (damage.IsEmpty())
+    return eglSwapBuffers(egl_display, egl_surface);
+
+  // Both are in GL window coordinates, origin at the bottom left.
+  int32_t rect[4] = { damage.x(), damage.y(), damage.width(), damage.height() };
+  if (!swap_buffers_with_damage_(egl_display, egl_surface, rect, 1))
+    return false;
+
+  posted_damage_pixels_ = damage.size().GetArea();
+  return true;
+}
+
+bool SurfaceOzoneWayland::SupportsAsyncSwap() {
+  return true;
+}
+
+void SurfaceOzoneWayland::CountDamage() {
+  WaylandWindow* window = WaylandDisplay::GetInstance()->GetWindow(handle_);
+  int64_t window_pixels = window ? window->GetBounds().size().GetArea() : 0;
+  int64_t damaged_pixels = posted_damage_pixels_ < 0 ?
+      window_pixels : std::min(posted_damage_pixels_, window_pixels);
+  posted_damage_pixels_ = -1;
+  if (!window_pixels)
+    return;
+
+  damaged_pixels_ += damaged_pixels;
+  window_pixels_ += window_pixels;
+  UMA_HISTOGRAM_PERCENTAGE("Ozone.Wayland.SwapDamagePercent",
+                           damaged_pixels * 100 / window_pixels);
+  TRACE_COUNTER_ID2("ozone", "WaylandSwapDamage", this,
+                    "damaged_pixels", damaged_pixels_,
+                    "window_pixels", window_pixels_);
+}
+
+void SurfaceOzoneWayland::FinishSwap(const base::Closure& swap_ack) {
+  CountDamage();
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(handle_);
+  if (!window || !window->ShellSurface()) {
+    if (!swap_ack.is_null())
+      base::ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE, swap_ack);
+    return;
+  }
+
+  if (!swap_ack.is_null())
+    frame_clock_->AckSwap(swap_ack);
+  display->FlushDisplay();
 }
 
 }  // namespace ozonewayland
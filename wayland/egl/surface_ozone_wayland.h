@@ -6,12 +6,15 @@
 #define OZONE_WAYLAND_EGL_SURFACE_OZONE_WAYLAND
 
 #include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "ui/gfx/gfx_export.h"
 #include "ui/ozone/public/surface_ozone_egl.h"
 
 namespace ozonewayland {
 
+class WaylandFrameClock;
+
 // Provides EGL support for SurfaceOzone.
 class SurfaceOzoneWayland : public ui::SurfaceOzoneEGL {
  public:
@@ -21,12 +24,47 @@ class SurfaceOzoneWayland : public ui::SurfaceOzoneEGL {
   // SurfaceOzone:
   intptr_t GetNativeWindow() override;
   bool ResizeNativeWindow(const gfx::Size& viewport_size) override;
+  void WillSwapBuffers() override;
   bool OnSwapBuffers() override;
   void OnSwapBuffersAsync(const ui::SwapCompletionCallback& callback) override;
   scoped_ptr<gfx::VSyncProvider> CreateVSyncProvider() override;
+  bool InitializePostSubBuffer(void* egl_display, void* egl_surface) override;
+  bool OnPostSubBuffer(void* egl_display,
+                       void* egl_surface,
+                       int x,
+                       int y,
+                       int width,
+                       int height) override;
+  bool SupportsAsyncSwap() override;
 
  private:
+  // eglSwapBuffersWithDamageKHR and EXT, spelled without the EGL types to
+  // keep EGL headers out of here.
+  typedef unsigned (*SwapBuffersWithDamageProc)(void* egl_display,
+                                                void* egl_surface,
+                                                int32_t* rects,
+                                                int32_t n_rects);
+
+  // Adds the swap being finished to the damage counters.
+  void CountDamage();
+  // Called after the swap. |swap_ack| is run once the compositor has caught
+  // up, see WaylandFrameClock.
+  void FinishSwap(const base::Closure& swap_ack);
+
   unsigned handle_;
+  scoped_refptr<WaylandFrameClock> frame_clock_;
+  // EGL surface |swap_buffers_with_damage_| was looked up for. Partial swaps
+  // need the surface to preserve its back buffer, which is set up by
+  // InitializePostSubBuffer() when the surface is created.
+  void* partial_swap_surface_;
+  SwapBuffersWithDamageProc swap_buffers_with_damage_;
+  // Pixels damaged by swaps since the surface was created, and pixels those
+  // swaps would have damaged without partial swap.
+  int64_t damaged_pixels_;
+  int64_t window_pixels_;
+  // Pixels damaged by the last OnPostSubBuffer(), -1 if the swap being
+  // finished damaged the whole window.
+  int64_t posted_damage_pixels_;
   DISALLOW_COPY_AND_ASSIGN(SurfaceOzoneWayland);
 };
 
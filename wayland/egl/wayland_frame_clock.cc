@@ -0,0 +1,374 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/egl/wayland_frame_clock.h"
+
+#include <wayland-client.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/single_thread_task_runner.h"
+#include "base/thread_task_runner_handle.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/protocol/presentation-time-client-protocol.h"
+
+namespace ozonewayland {
+
+namespace {
+
+// How long a swap waits for the compositor before going ahead anyway.
+const int kMaxFrameWaitMs = 100;
+
+// Frame callbacks kept at most, the oldest are dropped beyond that.
+const size_t kMaxFrameCallbacks = 8;
+
+// wl_proxy_create_wrapper() is only available since libwayland 1.11.
+#if WAYLAND_VERSION_MAJOR > 1 || \
+    (WAYLAND_VERSION_MAJOR == 1 && WAYLAND_VERSION_MINOR >= 11)
+#define HAVE_WL_PROXY_WRAPPER
+#endif
+
+// Returns a proxy standing for |proxy| whose new objects are created on
+// |queue|, which has to be passed to DestroyQueueProxy(). Without proxy
+// wrappers it's |proxy| itself, and new objects have to be moved to |queue|
+// with SetQueue().
+template <typename T>
+T* CreateQueueProxy(T* proxy, wl_event_queue* queue) {
+#if defined(HAVE_WL_PROXY_WRAPPER)
+  T* wrapper = static_cast<T*>(wl_proxy_create_wrapper(proxy));
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(wrapper), queue);
+  return wrapper;
+#else
+  return proxy;
+#endif
+}
+
+template <typename T>
+void DestroyQueueProxy(T* proxy) {
+#if defined(HAVE_WL_PROXY_WRAPPER)
+  wl_proxy_wrapper_destroy(proxy);
+#endif
+}
+
+// Moves |proxy|, created from a proxy returned by CreateQueueProxy(), to
+// |queue| if it isn't there yet. Frame callbacks and presentation feedback
+// only get events after the next commit of their surface, which comes after
+// this, so none can be queued on the default queue in between.
+template <typename T>
+void SetQueue(T* proxy, wl_event_queue* queue) {
+#if !defined(HAVE_WL_PROXY_WRAPPER)
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(proxy), queue);
+#endif
+}
+
+}  // namespace
+
+WaylandFrameClock::WaylandFrameClock(size_t max_pending_frames)
+    : max_pending_frames_(std::max<size_t>(max_pending_frames, 1)),
+      surface_(NULL),
+      surface_wrapper_(NULL),
+      presentation_wrapper_(NULL),
+      next_ack_id_(0) {
+}
+
+WaylandFrameClock::~WaylandFrameClock() {
+  DCHECK(!surface_wrapper_);
+  DCHECK(!presentation_wrapper_);
+  DCHECK(pending_frames_.empty());
+  DCHECK(pending_feedback_.empty());
+}
+
+void WaylandFrameClock::RequestFrame(wl_surface* surface) {
+  static const struct wl_callback_listener kFrameListener = {
+    WaylandFrameClock::FrameDone
+  };
+  static const struct wp_presentation_feedback_listener kFeedbackListener = {
+    WaylandFrameClock::SyncOutput,
+    WaylandFrameClock::Presented,
+    WaylandFrameClock::Discarded
+  };
+
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  if (surface != surface_) {
+    if (surface_wrapper_)
+      DestroyQueueProxy(surface_wrapper_);
+    surface_ = surface;
+    surface_wrapper_ = CreateQueueProxy(surface, display->frame_queue());
+  }
+
+  wp_presentation* presentation = display->GetPresentation();
+  if (presentation && !presentation_wrapper_) {
+    presentation_wrapper_ =
+        CreateQueueProxy(presentation, display->frame_queue());
+  }
+
+  // The frame queue isn't dispatched before callback and feedback have their
+  // listeners.
+  base::AutoLock queue_lock(display->frame_queue_lock());
+  base::AutoLock lock(lock_);
+  while (pending_frames_.size() >=
+         std::max(kMaxFrameCallbacks, max_pending_frames_)) {
+    DropOldestFrame();
+  }
+
+  wl_callback* callback = wl_surface_frame(surface_wrapper_);
+  SetQueue(callback, display->frame_queue());
+  wl_callback_add_listener(callback, &kFrameListener, this);
+  pending_frames_.push_back(callback);
+  if (presentation_wrapper_) {
+    PendingFeedback pending;
+    pending.feedback = wp_presentation_feedback(presentation_wrapper_, surface);
+    SetQueue(pending.feedback, display->frame_queue());
+    pending.swap_time = base::TimeTicks::Now();
+    wp_presentation_feedback_add_listener(pending.feedback,
+                                          &kFeedbackListener,
+                                          this);
+    pending_feedback_.push_back(pending);
+    stats_.frames_swapped++;
+    TRACE_EVENT_ASYNC_BEGIN0("ozone", "WaylandPresentationFeedback",
+                             pending.feedback);
+  }
+  TRACE_COUNTER_ID1("ozone", "WaylandPendingFrames", this,
+                    pending_frames_.size());
+}
+
+void WaylandFrameClock::AckSwap(const base::Closure& swap_ack) {
+  base::AutoLock lock(lock_);
+  task_runner_ = base::ThreadTaskRunnerHandle::Get();
+  HeldAck held_ack;
+  held_ack.id = next_ack_id_++;
+  held_ack.ack = swap_ack;
+  held_acks_.push_back(held_ack);
+  ReleaseAcks();
+  if (!held_acks_.empty()) {
+    task_runner_->PostDelayedTask(
+        FROM_HERE,
+        base::Bind(&WaylandFrameClock::OnAckTimeout, this, held_ack.id),
+        base::TimeDelta::FromMilliseconds(kMaxFrameWaitMs));
+  }
+}
+
+void WaylandFrameClock::Shutdown() {
+  base::AutoLock queue_lock(WaylandDisplay::GetInstance()->frame_queue_lock());
+  base::AutoLock lock(lock_);
+  if (surface_wrapper_) {
+    DestroyQueueProxy(surface_wrapper_);
+    surface_wrapper_ = NULL;
+    surface_ = NULL;
+  }
+
+  if (presentation_wrapper_) {
+    DestroyQueueProxy(presentation_wrapper_);
+    presentation_wrapper_ = NULL;
+  }
+
+  for (wl_callback* callback : pending_frames_)
+    wl_callback_destroy(callback);
+
+  pending_frames_.clear();
+  for (const PendingFeedback& pending : pending_feedback_) {
+    wp_presentation_feedback_destroy(pending.feedback);
+    TRACE_EVENT_ASYNC_END0("ozone", "WaylandPresentationFeedback",
+                           pending.feedback);
+  }
+
+  pending_feedback_.clear();
+  // Whoever waits for the acks must not be left hanging.
+  while (!held_acks_.empty()) {
+    task_runner_->PostTask(FROM_HERE, held_acks_.front().ack);
+    held_acks_.pop_front();
+  }
+}
+
+base::TimeTicks WaylandFrameClock::last_frame_time() {
+  base::AutoLock lock(lock_);
+  return last_frame_time_;
+}
+
+bool WaylandFrameClock::GetPresentationTiming(base::TimeTicks* timebase,
+                                              base::TimeDelta* interval) {
+  base::AutoLock lock(lock_);
+  if (last_present_time_.is_null() || refresh_interval_ <= base::TimeDelta())
+    return false;
+
+  *timebase = last_present_time_;
+  *interval = refresh_interval_;
+  return true;
+}
+
+ui::WaylandFrameTimingStats WaylandFrameClock::timing_stats() {
+  base::AutoLock lock(lock_);
+  return stats_;
+}
+
+// static
+void WaylandFrameClock::FrameDone(void* data,
+                                  wl_callback* callback,
+                                  uint32_t time) {
+  static_cast<WaylandFrameClock*>(data)->OnFrameDone(callback, time);
+}
+
+void WaylandFrameClock::OnFrameDone(wl_callback* callback, uint32_t time) {
+  TRACE_EVENT0("ozone", "WaylandFrameClock::OnFrameDone");
+  base::AutoLock lock(lock_);
+  std::deque<wl_callback*>::iterator it =
+      std::find(pending_frames_.begin(), pending_frames_.end(), callback);
+  // Dropped while the event was being dispatched.
+  if (it == pending_frames_.end())
+    return;
+
+  pending_frames_.erase(it);
+  wl_callback_destroy(callback);
+  last_frame_time_ =
+      WaylandDisplay::ProtocolTimeToTimeTicks(time, base::TimeTicks::Now());
+  TRACE_COUNTER_ID1("ozone", "WaylandPendingFrames", this,
+                    pending_frames_.size());
+  ReleaseAcks();
+}
+
+// static
+void WaylandFrameClock::SyncOutput(void* data,
+                                   wp_presentation_feedback* feedback,
+                                   wl_output* output) {
+}
+
+// static
+void WaylandFrameClock::Presented(void* data,
+                                  wp_presentation_feedback* feedback,
+                                  uint32_t tv_sec_hi,
+                                  uint32_t tv_sec_lo,
+                                  uint32_t tv_nsec,
+                                  uint32_t refresh,
+                                  uint32_t seq_hi,
+                                  uint32_t seq_lo,
+                                  uint32_t flags) {
+  static_cast<WaylandFrameClock*>(data)->OnPresented(
+      feedback, tv_sec_hi, tv_sec_lo, tv_nsec, refresh, flags);
+}
+
+// static
+void WaylandFrameClock::Discarded(void* data,
+                                  wp_presentation_feedback* feedback) {
+  static_cast<WaylandFrameClock*>(data)->OnDiscarded(feedback);
+}
+
+void WaylandFrameClock::OnPresented(wp_presentation_feedback* feedback,
+                                    uint32_t tv_sec_hi,
+                                    uint32_t tv_sec_lo,
+                                    uint32_t tv_nsec,
+                                    uint32_t refresh,
+                                    uint32_t flags) {
+  base::AutoLock lock(lock_);
+  base::TimeTicks swap_time;
+  if (!TakeFeedback(feedback, &swap_time))
+    return;
+
+  bool zero_copy = flags & WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY;
+  TRACE_EVENT_ASYNC_END2("ozone", "WaylandPresentationFeedback", feedback,
+                         "presented", true, "zero_copy", zero_copy);
+  stats_.frames_presented++;
+  if (zero_copy)
+    stats_.frames_zero_copy++;
+
+  stats_.refresh_ns = refresh;
+  refresh_interval_ = base::TimeDelta::FromMicroseconds(
+      refresh / base::Time::kNanosecondsPerMicrosecond);
+
+  base::TimeTicks present_time;
+  if (!WaylandDisplay::GetInstance()->PresentationTimeToTimeTicks(
+          tv_sec_hi, tv_sec_lo, tv_nsec, &present_time)) {
+    return;
+  }
+
+  base::TimeDelta latency = present_time - swap_time;
+  if (latency < base::TimeDelta())
+    latency = base::TimeDelta();
+
+  if (stats_.latency_samples) {
+    stats_.jitter_sum_us +=
+        std::abs((latency - last_latency_).InMicroseconds());
+  }
+
+  stats_.latency_samples++;
+  stats_.latency_sum_us += latency.InMicroseconds();
+  stats_.latency_max_us =
+      std::max(stats_.latency_max_us, latency.InMicroseconds());
+  last_latency_ = latency;
+  last_present_time_ = present_time;
+  TRACE_COUNTER_ID1("ozone", "WaylandSwapToPresentUs", this,
+                    latency.InMicroseconds());
+}
+
+void WaylandFrameClock::OnDiscarded(wp_presentation_feedback* feedback) {
+  base::AutoLock lock(lock_);
+  base::TimeTicks swap_time;
+  if (!TakeFeedback(feedback, &swap_time))
+    return;
+
+  TRACE_EVENT_ASYNC_END1("ozone", "WaylandPresentationFeedback", feedback,
+                         "presented", false);
+  stats_.frames_discarded++;
+  TRACE_COUNTER_ID1("ozone", "WaylandDiscardedFrames", this,
+                    stats_.frames_discarded);
+}
+
+bool WaylandFrameClock::TakeFeedback(wp_presentation_feedback* feedback,
+                                     base::TimeTicks* swap_time) {
+  lock_.AssertAcquired();
+  for (std::vector<PendingFeedback>::iterator it = pending_feedback_.begin();
+       it != pending_feedback_.end(); ++it) {
+    if (it->feedback != feedback)
+      continue;
+
+    *swap_time = it->swap_time;
+    pending_feedback_.erase(it);
+    wp_presentation_feedback_destroy(feedback);
+    return true;
+  }
+
+  // Shut down while the event was being dispatched.
+  return false;
+}
+
+void WaylandFrameClock::ReleaseAcks() {
+  lock_.AssertAcquired();
+  while (!held_acks_.empty() && pending_frames_.size() < max_pending_frames_) {
+    task_runner_->PostTask(FROM_HERE, held_acks_.front().ack);
+    held_acks_.pop_front();
+  }
+}
+
+void WaylandFrameClock::DropOldestFrame() {
+  WaylandDisplay::GetInstance()->frame_queue_lock().AssertAcquired();
+  lock_.AssertAcquired();
+  wl_callback_destroy(pending_frames_.front());
+  pending_frames_.pop_front();
+}
+
+void WaylandFrameClock::OnAckTimeout(uint64_t id) {
+  TRACE_EVENT0("ozone", "WaylandFrameClock::OnAckTimeout");
+  base::AutoLock queue_lock(WaylandDisplay::GetInstance()->frame_queue_lock());
+  base::AutoLock lock(lock_);
+  // Released in time.
+  if (held_acks_.empty() || held_acks_.front().id > id)
+    return;
+
+  while (pending_frames_.size() >= max_pending_frames_)
+    DropOldestFrame();
+
+  TRACE_COUNTER_ID1("ozone", "WaylandPendingFrames", this,
+                    pending_frames_.size());
+  ReleaseAcks();
+  while (!held_acks_.empty() && held_acks_.front().id <= id) {
+    task_runner_->PostTask(FROM_HERE, held_acks_.front().ack);
+    held_acks_.pop_front();
+  }
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,150 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_EGL_WAYLAND_FRAME_CLOCK_H_
+#define OZONE_WAYLAND_EGL_WAYLAND_FRAME_CLOCK_H_
+
+#include <deque>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "ozone/platform/wayland_frame_timing_stats.h"
+
+struct wl_callback;
+struct wl_output;
+struct wl_surface;
+struct wp_presentation;
+struct wp_presentation_feedback;
+
+namespace base {
+class SingleThreadTaskRunner;
+}
+
+namespace ozonewayland {
+
+// Follows the repaint cycle of the compositor for one surface through
+// wl_surface.frame callbacks. A callback is requested before every swap, so
+// that it is part of the commit done by eglSwapBuffers, and fires when the
+// compositor has shown the frame. This gives the vsync phase and tells how
+// many frames the client is ahead of the compositor.
+// If the compositor supports presentation-time, feedback is requested for
+// every swap as well and accumulated in WaylandFrameTimingStats.
+// Callbacks are requested on the GPU thread but fire on the thread
+// dispatching WaylandDisplay::frame_queue(), hence the lock and the reference
+// counting.
+class WaylandFrameClock : public base::RefCountedThreadSafe<WaylandFrameClock> {
+ public:
+  explicit WaylandFrameClock(size_t max_pending_frames);
+
+  // Requests a frame callback and presentation feedback for the frame about
+  // to be swapped to |surface|. Called on the GPU thread before the swap.
+  void RequestFrame(wl_surface* surface);
+  // Posts |swap_ack| back to the calling thread as soon as fewer than
+  // |max_pending_frames| frames wait for the compositor. Called after the
+  // swap. Gives up waiting after a while, a hidden surface may never get a
+  // frame callback.
+  void AckSwap(const base::Closure& swap_ack);
+  // Drops frame callbacks which haven't fired yet and posts the acks waiting
+  // for them. Needs to be called before the surface is destroyed, on the
+  // thread which requested the frames.
+  void Shutdown();
+
+  // Time the compositor last showed a frame of the surface, null until then.
+  base::TimeTicks last_frame_time();
+  // Time the last frame was presented and the refresh interval of the output
+  // it was presented on, as reported by presentation feedback. Returns false
+  // if there is no such feedback.
+  bool GetPresentationTiming(base::TimeTicks* timebase,
+                             base::TimeDelta* interval);
+  ui::WaylandFrameTimingStats timing_stats();
+
+ private:
+  friend class base::RefCountedThreadSafe<WaylandFrameClock>;
+  ~WaylandFrameClock();
+
+  struct HeldAck {
+    uint64_t id;
+    base::Closure ack;
+  };
+
+  struct PendingFeedback {
+    wp_presentation_feedback* feedback;
+    base::TimeTicks swap_time;
+  };
+
+  static void FrameDone(void* data, wl_callback* callback, uint32_t time);
+  void OnFrameDone(wl_callback* callback, uint32_t time);
+  static void SyncOutput(void* data,
+                         wp_presentation_feedback* feedback,
+                         wl_output* output);
+  static void Presented(void* data,
+                        wp_presentation_feedback* feedback,
+                        uint32_t tv_sec_hi,
+                        uint32_t tv_sec_lo,
+                        uint32_t tv_nsec,
+                        uint32_t refresh,
+                        uint32_t seq_hi,
+                        uint32_t seq_lo,
+                        uint32_t flags);
+  static void Discarded(void* data, wp_presentation_feedback* feedback);
+  void OnPresented(wp_presentation_feedback* feedback,
+                   uint32_t tv_sec_hi,
+                   uint32_t tv_sec_lo,
+                   uint32_t tv_nsec,
+                   uint32_t refresh,
+                   uint32_t flags);
+  void OnDiscarded(wp_presentation_feedback* feedback);
+  // Removes |feedback| from |pending_feedback_| and destroys it. Returns false
+  // if it isn't pending anymore. |lock_| must be held.
+  bool TakeFeedback(wp_presentation_feedback* feedback,
+                    base::TimeTicks* swap_time);
+  // Posts the acks allowed by the number of pending frames. |lock_| must be
+  // held.
+  void ReleaseAcks();
+  // Destroys the oldest pending frame callback. The frame queue lock of the
+  // display and |lock_| must be held.
+  void DropOldestFrame();
+  // Called when the ack |id| waited too long. The frames the compositor
+  // hasn't caught up with by now are considered stale and dropped, and all
+  // acks up to |id| are released.
+  void OnAckTimeout(uint64_t id);
+
+  const size_t max_pending_frames_;
+  // Surface the frames are requested for, and a wrapper of it on the frame
+  // queue of the display, or the surface itself with libwayland before 1.11.
+  // Only used on the GPU thread.
+  wl_surface* surface_;
+  wl_surface* surface_wrapper_;
+  // Wrapper of the presentation global on the frame queue, so that feedback
+  // is dispatched like the frame callbacks. The global itself with libwayland
+  // before 1.11. Only used on the GPU thread.
+  wp_presentation* presentation_wrapper_;
+  base::Lock lock_;
+  // Callbacks requested and not fired yet, oldest first. A surface which
+  // isn't shown gets no callbacks, so only a few are kept.
+  std::deque<wl_callback*> pending_frames_;
+  std::deque<HeldAck> held_acks_;
+  uint64_t next_ack_id_;
+  // Thread which requested the frames, acks are run there.
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  base::TimeTicks last_frame_time_;
+  // Feedback requested and not received yet, oldest first.
+  std::vector<PendingFeedback> pending_feedback_;
+  ui::WaylandFrameTimingStats stats_;
+  // Of the last presented frame. |last_present_time_| and |last_latency_| are
+  // only known if the presentation clock is the one of base::TimeTicks.
+  base::TimeTicks last_present_time_;
+  base::TimeDelta last_latency_;
+  base::TimeDelta refresh_interval_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandFrameClock);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_EGL_WAYLAND_FRAME_CLOCK_H_
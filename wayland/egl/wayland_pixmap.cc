@@ -4,41 +4,120 @@
 
 #include "ozone/wayland/egl/wayland_pixmap.h"
 
+#include <errno.h>
 #include <gbm.h>
+#include <linux/types.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/synchronization/lock.h"
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/egl/wayland_pixmap_pool.h"
+#include "ozone/wayland/overlay_planes.h"
+#include "ozone/wayland/protocol/linux-dmabuf-client-protocol.h"
+#include "ozone/wayland/window.h"
+
+// Only in linux/dma-buf.h of kernels 4.6 and later.
+#if !defined(DMA_BUF_IOCTL_SYNC)
+struct dma_buf_sync {
+  __u64 flags;
+};
+
+#define DMA_BUF_SYNC_WRITE (2 << 0)
+#define DMA_BUF_SYNC_START (0 << 2)
+#define DMA_BUF_SYNC_END (1 << 2)
+#define DMA_BUF_BASE 'b'
+#define DMA_BUF_IOCTL_SYNC _IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
+#endif
 
 namespace ozonewayland {
 
 namespace {
 
-int GetGbmFormatFromBufferFormat(ui::SurfaceFactoryOzone::BufferFormat fmt) {
-  switch (fmt) {
-    case ui::SurfaceFactoryOzone::RGBA_8888:
-      return GBM_BO_FORMAT_ARGB8888;
-    case ui::SurfaceFactoryOzone::RGBX_8888:
-      return GBM_BO_FORMAT_XRGB8888;
-    default:
-      NOTREACHED();
-      return 0;
+void SyncDmabuf(int dmabuf_fd, uint64_t flags) {
+  struct dma_buf_sync sync = { 0 };
+  sync.flags = flags;
+  // Kernels without the ioctl keep the mapping coherent on their own.
+  if (HANDLE_EINTR(ioctl(dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync)) &&
+      errno != ENOTTY) {
+    PLOG(ERROR) << "DMA_BUF_IOCTL_SYNC failed";
   }
 }
 
 }  // namespace
 
-WaylandPixmap::WaylandPixmap()
-    : bo_(NULL), dma_buf_(-1)  {
+WaylandPixmapBuffer::WaylandPixmapBuffer(gfx::BufferFormat format,
+                                         gfx::BufferUsage usage,
+                                         const gfx::Size& size)
+    : format_(format),
+      usage_(usage),
+      size_(size),
+      fourcc_(WaylandPixmap::GetFourccFromBufferFormat(format)),
+      bo_(NULL),
+      dma_buf_(-1),
+      byte_size_(0),
+      buffer_(NULL),
+      buffer_failed_(false),
+      busy_(0) {
 }
 
-bool WaylandPixmap::Initialize(gbm_device* device,
-                               ui::SurfaceFactoryOzone::BufferFormat format,
-                               const gfx::Size& size) {
+WaylandPixmapBuffer::~WaylandPixmapBuffer() {
+  if (buffer_) {
+    // Releases are dispatched holding the lock, so BufferRelease() can't
+    // run while or after the buffer is destroyed.
+    base::AutoLock lock(WaylandDisplay::GetInstance()->frame_queue_lock());
+    wl_buffer_destroy(buffer_);
+  }
+
+  if (bo_)
+    gbm_bo_destroy(bo_);
+
+  if (dma_buf_ >= 0)
+    close(dma_buf_);
+}
+
+bool WaylandPixmapBuffer::Allocate(gbm_device* device) {
   unsigned flags = GBM_BO_USE_RENDERING;
-  bo_ = gbm_bo_create(device,
-                      size.width(),
-                      size.height(),
-                      GetGbmFormatFromBufferFormat(format),
-                      flags);
+  switch (usage_) {
+    case gfx::BufferUsage::MAP:
+    case gfx::BufferUsage::PERSISTENT_MAP:
+      // Clients map the dma-buf and write to it in the layout they expect.
+      flags |= GBM_BO_USE_LINEAR;
+      break;
+    case gfx::BufferUsage::SCANOUT:
+      flags |= GBM_BO_USE_SCANOUT;
+      break;
+  }
+
+  if (!fourcc_) {
+    LOG(ERROR) << "Unsupported pixmap format.";
+    return false;
+  }
+
+  bool yuv = fourcc_ == GBM_FORMAT_NV12 || fourcc_ == GBM_FORMAT_YUV420;
+  int bo_height = size_.height();
+  if (yuv) {
+    // GBM can't allocate YUV buffers on most drivers. Allocate a linear
+    // 32bpp buffer instead, wide enough for a row of luma samples and tall
+    // enough for the luma plane followed by the subsampled chroma planes.
+    bo_height += (size_.height() + 1) / 2;
+    bo_ = gbm_bo_create(device,
+                        (size_.width() + 3) / 4,
+                        bo_height,
+                        GBM_FORMAT_ARGB8888,
+                        flags | GBM_BO_USE_LINEAR);
+  } else {
+    bo_ = gbm_bo_create(device,
+                        size_.width(),
+                        size_.height(),
+                        fourcc_,
+                        flags);
+  }
   if (!bo_) {
     LOG(ERROR) << "Failed to create GBM buffer object.";
     return false;
@@ -50,27 +129,247 @@ bool WaylandPixmap::Initialize(gbm_device* device,
     return false;
   }
 
+  int stride = gbm_bo_get_stride(bo_);
+  // Tiled buffers can be larger than their stride suggests, the dma-buf
+  // knows its real size.
+  off_t dma_buf_size = lseek(dma_buf_, 0, SEEK_END);
+  if (dma_buf_size > 0) {
+    byte_size_ = dma_buf_size;
+    lseek(dma_buf_, 0, SEEK_SET);
+  } else {
+    byte_size_ = static_cast<size_t>(stride) * bo_height;
+  }
+
+  int luma_size = stride * size_.height();
+  Plane luma = { stride, 0 };
+  planes_.push_back(luma);
+  if (fourcc_ == GBM_FORMAT_NV12) {
+    Plane chroma = { stride, luma_size };
+    planes_.push_back(chroma);
+  } else if (fourcc_ == GBM_FORMAT_YUV420) {
+    Plane u = { stride / 2, luma_size };
+    Plane v = { stride / 2,
+                luma_size + stride / 2 * ((size_.height() + 1) / 2) };
+    planes_.push_back(u);
+    planes_.push_back(v);
+  }
+
+  return true;
+}
+
+bool WaylandPixmapBuffer::IsMappable() const {
+  return usage_ == gfx::BufferUsage::MAP ||
+         usage_ == gfx::BufferUsage::PERSISTENT_MAP;
+}
+
+bool WaylandPixmapBuffer::Clear() {
+  DCHECK(IsMappable());
+  void* data = mmap(NULL, byte_size_, PROT_WRITE, MAP_SHARED, dma_buf_, 0);
+  if (data == MAP_FAILED)
+    return false;
+
+  SyncDmabuf(dma_buf_, DMA_BUF_SYNC_START | DMA_BUF_SYNC_WRITE);
+  memset(data, 0, byte_size_);
+  SyncDmabuf(dma_buf_, DMA_BUF_SYNC_END | DMA_BUF_SYNC_WRITE);
+  munmap(data, byte_size_);
+  return true;
+}
+
+int WaylandPixmapBuffer::GetPlaneStride(size_t plane) const {
+  DCHECK_LT(plane, planes_.size());
+  return planes_[plane].stride;
+}
+
+int WaylandPixmapBuffer::GetPlaneOffset(size_t plane) const {
+  DCHECK_LT(plane, planes_.size());
+  return planes_[plane].offset;
+}
+
+wl_buffer* WaylandPixmapBuffer::GetWLBuffer() {
+  if (buffer_ || buffer_failed_)
+    return buffer_;
+
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  zwp_linux_dmabuf_v1* linux_dmabuf = display->GetLinuxDmabuf();
+  // The buffer was allocated without an explicit layout, so the compositor
+  // has to be able to import it with the implicit one.
+  if (!linux_dmabuf ||
+      !display->IsDmabufFormatSupported(fourcc_, kDrmFormatModInvalid)) {
+    buffer_failed_ = true;
+    return NULL;
+  }
+
+  zwp_linux_buffer_params_v1* params =
+      zwp_linux_dmabuf_v1_create_params(linux_dmabuf);
+  for (size_t i = 0; i < planes_.size(); ++i) {
+    zwp_linux_buffer_params_v1_add(params,
+                                   dma_buf_,
+                                   i,
+                                   planes_[i].offset,
+                                   planes_[i].stride,
+                                   kDrmFormatModInvalid >> 32,
+                                   kDrmFormatModInvalid & 0xffffffff);
+  }
+  buffer_ = zwp_linux_buffer_params_v1_create_immed(params,
+                                                    size_.width(),
+                                                    size_.height(),
+                                                    fourcc_,
+                                                    0);
+  zwp_linux_buffer_params_v1_destroy(params);
+
+  static const struct wl_buffer_listener kBufferListener = {
+    WaylandPixmapBuffer::BufferRelease
+  };
+  if (buffer_) {
+    // The buffer can be destroyed on any thread, see the destructor. Nothing
+    // is released before the buffer is first attached, so moving it to the
+    // frame queue here can't miss an event.
+    base::AutoLock lock(display->frame_queue_lock());
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(buffer_),
+                       display->frame_queue());
+    wl_buffer_add_listener(buffer_, &kBufferListener, this);
+  }
+
+  return buffer_;
+}
+
+void WaylandPixmapBuffer::MarkAttached() {
+  base::subtle::NoBarrier_Store(&busy_, 1);
+}
+
+bool WaylandPixmapBuffer::IsBusy() const {
+  return base::subtle::NoBarrier_Load(&busy_) != 0;
+}
+
+// static
+void WaylandPixmapBuffer::BufferRelease(void* data, wl_buffer* buffer) {
+  WaylandPixmapBuffer* pixmap_buffer = static_cast<WaylandPixmapBuffer*>(data);
+  base::subtle::NoBarrier_Store(&pixmap_buffer->busy_, 0);
+}
+
+WaylandPixmap::WaylandPixmap(WaylandPixmapPool* pool)
+    : pool_(pool) {
+}
+
+// static
+uint32_t WaylandPixmap::GetFourccFromBufferFormat(gfx::BufferFormat format) {
+  switch (format) {
+    case gfx::BufferFormat::BGRA_8888:
+      return GBM_FORMAT_ARGB8888;
+    case gfx::BufferFormat::BGRX_8888:
+      return GBM_FORMAT_XRGB8888;
+    case gfx::BufferFormat::RGBA_8888:
+      return GBM_FORMAT_ABGR8888;
+    case gfx::BufferFormat::YUV_420:
+      return GBM_FORMAT_YUV420;
+    case gfx::BufferFormat::YUV_420_BIPLANAR:
+      return GBM_FORMAT_NV12;
+    default:
+      return 0;
+  }
+}
+
+bool WaylandPixmap::Initialize(gbm_device* device,
+                               gfx::BufferFormat format,
+                               gfx::BufferUsage usage,
+                               const gfx::Size& size) {
+  DCHECK(!buffer_);
+  if (pool_.get())
+    buffer_ = pool_->Take(format, usage, size);
+
+  if (!buffer_) {
+    buffer_.reset(new WaylandPixmapBuffer(format, usage, size));
+    if (!buffer_->Allocate(device)) {
+      buffer_.reset();
+      return false;
+    }
+  }
+
   return true;
 }
 
 WaylandPixmap::~WaylandPixmap() {
-  if (bo_)
-    gbm_bo_destroy(bo_);
+  if (pool_.get() && buffer_)
+    pool_->Put(buffer_.Pass());
+}
 
-  if (dma_buf_ > 0)
-    close(dma_buf_);
+int WaylandPixmap::GetPlaneFd(size_t plane) const {
+  DCHECK_LT(plane, buffer_->GetPlaneCount());
+  return buffer_->dma_buf();
+}
+
+int WaylandPixmap::GetPlaneStride(size_t plane) const {
+  return buffer_->GetPlaneStride(plane);
+}
+
+int WaylandPixmap::GetPlaneOffset(size_t plane) const {
+  return buffer_->GetPlaneOffset(plane);
+}
+
+wl_buffer* WaylandPixmap::GetWLBuffer() {
+  return buffer_->GetWLBuffer();
 }
 
 void* WaylandPixmap::GetEGLClientBuffer() {
-  return bo_;
+  // The buffer object of a YUV pixmap is only a container for its planes.
+  if (buffer_->GetPlaneCount() > 1)
+    return NULL;
+  return buffer_->bo();
 }
 
 int WaylandPixmap::GetDmaBufFd() {
-  return dma_buf_;
+  return buffer_->dma_buf();
 }
 
 int WaylandPixmap::GetDmaBufPitch() {
-  return gbm_bo_get_stride(bo_);
+  return GetPlaneStride(0);
+}
+
+uint32_t WaylandPixmap::GetDmaBufFourcc() {
+  return buffer_->fourcc();
+}
+
+std::vector<ui::NativePixmap::DmaBufPlane> WaylandPixmap::GetDmaBufPlanes() {
+  std::vector<ui::NativePixmap::DmaBufPlane> planes;
+  for (size_t i = 0; i < GetPlaneCount(); ++i) {
+    ui::NativePixmap::DmaBufPlane plane;
+    plane.fd = GetPlaneFd(i);
+    plane.offset = GetPlaneOffset(i);
+    plane.pitch = GetPlaneStride(i);
+    planes.push_back(plane);
+  }
+  return planes;
+}
+
+bool WaylandPixmap::ScheduleOverlayPlane(gfx::AcceleratedWidget widget,
+                                         int plane_z_order,
+                                         gfx::OverlayTransform plane_transform,
+                                         const gfx::Rect& display_bounds,
+                                         const gfx::RectF& crop_rect) {
+  if (plane_transform != gfx::OVERLAY_TRANSFORM_NONE)
+    return false;
+
+  WaylandWindow* window = WaylandDisplay::GetInstance()->GetWindow(widget);
+  wl_buffer* buffer = GetWLBuffer();
+  if (!window || !buffer)
+    return false;
+
+  // The planes keep the pixmap, and with it |buffer_|, as long as they may
+  // run the callback.
+  if (!window->OverlayPlanes()->SchedulePlane(
+          this,
+          base::Bind(&WaylandPixmapBuffer::IsBusy,
+                     base::Unretained(buffer_.get())),
+          buffer,
+          buffer_->size(),
+          plane_z_order,
+          display_bounds,
+          crop_rect)) {
+    return false;
+  }
+
+  buffer_->MarkAttached();
+  return true;
 }
 
 }  // namespace ozonewayland
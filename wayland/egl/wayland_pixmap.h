@@ -5,33 +5,136 @@
 #ifndef OZONE_WAYLAND_PIXMAP_
 #define OZONE_WAYLAND_PIXMAP_
 
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/atomicops.h"
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "ui/gfx/buffer_types.h"
 #include "ui/gfx/geometry/size.h"
+#include "ui/gfx/overlay_transform.h"
 #include "ui/ozone/public/native_pixmap.h"
-#include "ui/ozone/public/surface_factory_ozone.h"
 
 struct gbm_bo;
 struct gbm_device;
+struct wl_buffer;
 
 namespace ozonewayland {
 
+class WaylandPixmapPool;
+
+// The GBM buffer object backing a WaylandPixmap, along with its dma-buf and
+// the wl_buffer shared with the compositor. It outlives the pixmap when it is
+// parked in a WaylandPixmapPool for reuse.
+class WaylandPixmapBuffer {
+ public:
+  WaylandPixmapBuffer(gfx::BufferFormat format,
+                      gfx::BufferUsage usage,
+                      const gfx::Size& size);
+  ~WaylandPixmapBuffer();
+
+  bool Allocate(gbm_device* device);
+  // Whether clients map the buffer. Such buffers are linear.
+  bool IsMappable() const;
+  // Zeroes the contents of a mappable buffer, so that a recycled buffer
+  // doesn't show what a previous client put into it. Returns false if the
+  // dma-buf can't be mapped.
+  bool Clear();
+
+  gfx::BufferFormat format() const { return format_; }
+  gfx::BufferUsage usage() const { return usage_; }
+  const gfx::Size& size() const { return size_; }
+  // DRM fourcc code of the buffer.
+  uint32_t fourcc() const { return fourcc_; }
+  gbm_bo* bo() const { return bo_; }
+  int dma_buf() const { return dma_buf_; }
+  // Size of the dma-buf in bytes.
+  size_t byte_size() const { return byte_size_; }
+
+  size_t GetPlaneCount() const { return planes_.size(); }
+  int GetPlaneStride(size_t plane) const;
+  int GetPlaneOffset(size_t plane) const;
+
+  // See WaylandPixmap::GetWLBuffer().
+  wl_buffer* GetWLBuffer();
+  // Called when the wl_buffer was attached to a surface. The buffer is busy
+  // until the compositor releases it and can't be recycled before.
+  void MarkAttached();
+  bool IsBusy() const;
+
+ private:
+  struct Plane {
+    int stride;
+    int offset;
+  };
+
+  static void BufferRelease(void* data, wl_buffer* buffer);
+
+  const gfx::BufferFormat format_;
+  const gfx::BufferUsage usage_;
+  const gfx::Size size_;
+  uint32_t fourcc_;
+  gbm_bo* bo_;
+  int dma_buf_;
+  size_t byte_size_;
+  std::vector<Plane> planes_;
+  wl_buffer* buffer_;
+  // Set once creating |buffer_| failed, so that it isn't tried every frame.
+  bool buffer_failed_;
+  // Written on the thread dispatching Wayland events when the compositor
+  // releases |buffer_|, while holding WaylandDisplay::frame_queue_lock().
+  base::subtle::Atomic32 busy_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandPixmapBuffer);
+};
+
 class WaylandPixmap : public ui::NativePixmap {
  public:
-  WaylandPixmap();
+  // Buffers are taken from and returned to |pool| if it isn't NULL.
+  explicit WaylandPixmap(WaylandPixmapPool* pool);
+
+  // Returns the DRM fourcc code of |format|, 0 if pixmaps of |format| aren't
+  // supported.
+  static uint32_t GetFourccFromBufferFormat(gfx::BufferFormat format);
+
   bool Initialize(gbm_device* device,
-                  ui::SurfaceFactoryOzone::BufferFormat format,
+                  gfx::BufferFormat format,
+                  gfx::BufferUsage usage,
                   const gfx::Size& size);
 
+  // Number of planes of the pixmap, 2 for NV12 and 3 for YUV420.
+  size_t GetPlaneCount() const { return buffer_->GetPlaneCount(); }
+  // The dma-buf fd, stride and offset in bytes of |plane|. All planes of a
+  // pixmap share one dma-buf.
+  int GetPlaneFd(size_t plane) const;
+  int GetPlaneStride(size_t plane) const;
+  int GetPlaneOffset(size_t plane) const;
+
+  // Returns a wl_buffer referencing the dma-buf of the pixmap, which can be
+  // attached to a surface without copying. It is created on first use. NULL
+  // if the compositor can't import the buffer. The pixmap owns the buffer.
+  wl_buffer* GetWLBuffer();
+
   // NativePixmap:
   void* GetEGLClientBuffer() override;
   int GetDmaBufFd() override;
   int GetDmaBufPitch() override;
+  uint32_t GetDmaBufFourcc() override;
+  std::vector<ui::NativePixmap::DmaBufPlane> GetDmaBufPlanes() override;
+  bool ScheduleOverlayPlane(gfx::AcceleratedWidget widget,
+                            int plane_z_order,
+                            gfx::OverlayTransform plane_transform,
+                            const gfx::Rect& display_bounds,
+                            const gfx::RectF& crop_rect) override;
 
  private:
   ~WaylandPixmap() override;
 
-  gbm_bo* bo_;
-  int dma_buf_;
+  scoped_refptr<WaylandPixmapPool> pool_;
+  scoped_ptr<WaylandPixmapBuffer> buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(WaylandPixmap);
 };
@@ -0,0 +1,143 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/egl/wayland_pixmap_pool.h"
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/wayland/egl/wayland_pixmap.h"
+
+namespace ozonewayland {
+
+WaylandPixmapPool::WaylandPixmapPool(size_t budget_bytes)
+    : budget_bytes_(budget_bytes),
+      memory_pressure_listener_(
+          base::Bind(&WaylandPixmapPool::OnMemoryPressure,
+                     base::Unretained(this))),
+      parked_bytes_(0),
+      shut_down_(false),
+      hits_(0),
+      misses_(0),
+      evictions_(0) {
+}
+
+WaylandPixmapPool::~WaylandPixmapPool() {
+  STLDeleteElements(&buffers_);
+  if (hits_ + misses_) {
+    VLOG(1) << "WaylandPixmapPool: " << hits_ << " hits, " << misses_
+            << " misses (" << hits_ * 100 / (hits_ + misses_) << "%), "
+            << evictions_ << " evictions";
+  }
+}
+
+scoped_ptr<WaylandPixmapBuffer> WaylandPixmapPool::Take(
+    gfx::BufferFormat format,
+    gfx::BufferUsage usage,
+    const gfx::Size& size) {
+  scoped_ptr<WaylandPixmapBuffer> buffer;
+  {
+    base::AutoLock lock(lock_);
+    for (std::list<WaylandPixmapBuffer*>::iterator it = buffers_.begin();
+         it != buffers_.end(); ++it) {
+      WaylandPixmapBuffer* parked = *it;
+      // Buffers still shown by the compositor can't be written to yet.
+      if (parked->format() != format || parked->usage() != usage ||
+          parked->size() != size || parked->IsBusy()) {
+        continue;
+      }
+
+      buffer.reset(parked);
+      buffers_.erase(it);
+      parked_bytes_ -= parked->byte_size();
+      break;
+    }
+  }
+
+  // None of the clients may see what another one left in the buffer.
+  if (buffer && !buffer->Clear()) {
+    LOG(WARNING) << "Failed to clear recycled pixmap buffer.";
+    buffer.reset();
+  }
+
+  base::AutoLock lock(lock_);
+  if (buffer)
+    hits_++;
+  else
+    misses_++;
+  UpdateCounters();
+  return buffer.Pass();
+}
+
+void WaylandPixmapPool::Put(scoped_ptr<WaylandPixmapBuffer> buffer) {
+  if (!buffer->IsMappable())
+    return;
+
+  base::AutoLock lock(lock_);
+  if (shut_down_ || buffer->byte_size() > budget_bytes_)
+    return;
+
+  parked_bytes_ += buffer->byte_size();
+  buffers_.push_front(buffer.release());
+  TrimLocked(budget_bytes_);
+}
+
+void WaylandPixmapPool::Trim(size_t budget_bytes) {
+  base::AutoLock lock(lock_);
+  TrimLocked(budget_bytes);
+}
+
+void WaylandPixmapPool::Shutdown() {
+  base::AutoLock lock(lock_);
+  shut_down_ = true;
+  STLDeleteElements(&buffers_);
+  parked_bytes_ = 0;
+  UpdateCounters();
+}
+
+void WaylandPixmapPool::TrimLocked(size_t budget_bytes) {
+  lock_.AssertAcquired();
+  // Buffers the compositor may still read from are kept over budget until a
+  // later trim.
+  std::list<WaylandPixmapBuffer*>::iterator it = buffers_.end();
+  while (parked_bytes_ > budget_bytes && it != buffers_.begin()) {
+    --it;
+    WaylandPixmapBuffer* buffer = *it;
+    if (buffer->IsBusy())
+      continue;
+
+    it = buffers_.erase(it);
+    parked_bytes_ -= buffer->byte_size();
+    delete buffer;
+    evictions_++;
+  }
+
+  UpdateCounters();
+}
+
+void WaylandPixmapPool::UpdateCounters() {
+  TRACE_COUNTER_ID2("ozone", "WaylandPixmapPool", this,
+                    "parked_bytes", parked_bytes_,
+                    "parked_buffers", buffers_.size());
+  TRACE_COUNTER_ID2("ozone", "WaylandPixmapPoolReuse", this,
+                    "hits", hits_,
+                    "misses", misses_);
+}
+
+void WaylandPixmapPool::OnMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel level) {
+  switch (level) {
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+      break;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+      Trim(budget_bytes_ / 2);
+      break;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+      Trim(0);
+      break;
+  }
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,78 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_EGL_WAYLAND_PIXMAP_POOL_H_
+#define OZONE_WAYLAND_EGL_WAYLAND_PIXMAP_POOL_H_
+
+#include <list>
+
+#include "base/macros.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "ui/gfx/buffer_types.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace ozonewayland {
+
+class WaylandPixmapBuffer;
+
+// Keeps the buffers of released WaylandPixmaps, so that pixmaps of the same
+// size, format and usage can reuse them instead of allocating new buffer
+// objects. Tile raster goes through many buffers of the same size. Pixmaps
+// go to different clients, so recycled buffers are cleared before they are
+// handed out. Only buffers clients map are parked: they are linear and can
+// always be cleared through a mapping, scanout buffers may be tiled and
+// can't. Parked buffers are kept up to a memory budget, least recently
+// parked ones are destroyed first. Buffers are returned from any thread, so
+// the pool is thread safe.
+class WaylandPixmapPool : public base::RefCountedThreadSafe<WaylandPixmapPool> {
+ public:
+  explicit WaylandPixmapPool(size_t budget_bytes);
+
+  // Returns a parked buffer matching |format|, |usage| and |size| which the
+  // compositor has released, with its contents cleared. NULL if there is
+  // none.
+  scoped_ptr<WaylandPixmapBuffer> Take(gfx::BufferFormat format,
+                                       gfx::BufferUsage usage,
+                                       const gfx::Size& size);
+  // Parks |buffer| for reuse if it is mappable, destroys it otherwise.
+  void Put(scoped_ptr<WaylandPixmapBuffer> buffer);
+  // Destroys parked buffers until at most |budget_bytes| are left, or only
+  // buffers still used by the compositor.
+  void Trim(size_t budget_bytes);
+  // Destroys all parked buffers and stops parking new ones, called when the
+  // GBM device goes away.
+  void Shutdown();
+
+ private:
+  friend class base::RefCountedThreadSafe<WaylandPixmapPool>;
+
+  ~WaylandPixmapPool();
+
+  void TrimLocked(size_t budget_bytes);
+  void UpdateCounters();
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level);
+
+  const size_t budget_bytes_;
+  base::MemoryPressureListener memory_pressure_listener_;
+
+  base::Lock lock_;
+  // Most recently parked first.
+  std::list<WaylandPixmapBuffer*> buffers_;
+  size_t parked_bytes_;
+  bool shut_down_;
+  // Statistics, logged when the pool is destroyed.
+  uint64_t hits_;
+  uint64_t misses_;
+  uint64_t evictions_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandPixmapPool);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_EGL_WAYLAND_PIXMAP_POOL_H_
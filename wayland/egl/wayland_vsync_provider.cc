@@ -0,0 +1,65 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/egl/wayland_vsync_provider.h"
+
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/egl/wayland_frame_clock.h"
+#include "ozone/wayland/screen.h"
+#include "ozone/wayland/shell/shell_surface.h"
+#include "ozone/wayland/window.h"
+
+namespace ozonewayland {
+
+namespace {
+
+// Used until the compositor tells us about the output mode.
+const int64 kDefaultIntervalUs = base::Time::kMicrosecondsPerSecond / 60;
+
+}  // namespace
+
+WaylandVSyncProvider::WaylandVSyncProvider(
+    unsigned handle,
+    const scoped_refptr<WaylandFrameClock>& frame_clock)
+    : handle_(handle),
+      frame_clock_(frame_clock) {
+}
+
+WaylandVSyncProvider::~WaylandVSyncProvider() {
+}
+
+void WaylandVSyncProvider::GetVSyncParameters(
+    const UpdateVSyncCallback& callback) {
+  // Presentation feedback has the exact time of the last vblank and the
+  // interval of the output the surface is shown on.
+  base::TimeTicks presentation_time;
+  base::TimeDelta presentation_interval;
+  if (frame_clock_->GetPresentationTiming(&presentation_time,
+                                          &presentation_interval)) {
+    callback.Run(presentation_time, presentation_interval);
+    return;
+  }
+
+  // Without a frame there is no phase, keep what the scheduler has.
+  base::TimeTicks timebase = frame_clock_->last_frame_time();
+  if (timebase.is_null())
+    return;
+
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(handle_);
+  WaylandScreen* screen = NULL;
+  if (window && window->ShellSurface())
+    screen = window->ShellSurface()->CurrentScreen();
+  if (!screen)
+    screen = display->PrimaryScreen();
+
+  // The refresh rate is in mHz.
+  int32_t refresh = screen ? screen->RefreshRate() : 0;
+  base::TimeDelta interval = base::TimeDelta::FromMicroseconds(
+      refresh > 0 ? base::Time::kMicrosecondsPerSecond * 1000 / refresh
+                  : kDefaultIntervalUs);
+  callback.Run(timebase, interval);
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,38 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_EGL_WAYLAND_VSYNC_PROVIDER_H_
+#define OZONE_WAYLAND_EGL_WAYLAND_VSYNC_PROVIDER_H_
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "ui/gfx/vsync_provider.h"
+
+namespace ozonewayland {
+
+class WaylandFrameClock;
+
+// Reports the refresh interval of the output a window is shown on and the
+// phase of the compositor's repaint cycle, taken from presentation feedback if
+// the compositor supports it and from the frame callbacks of the window's
+// surface otherwise.
+class WaylandVSyncProvider : public gfx::VSyncProvider {
+ public:
+  WaylandVSyncProvider(unsigned handle,
+                       const scoped_refptr<WaylandFrameClock>& frame_clock);
+  ~WaylandVSyncProvider() override;
+
+  // gfx::VSyncProvider:
+  void GetVSyncParameters(const UpdateVSyncCallback& callback) override;
+
+ private:
+  unsigned handle_;
+  scoped_refptr<WaylandFrameClock> frame_clock_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandVSyncProvider);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_EGL_WAYLAND_VSYNC_PROVIDER_H_
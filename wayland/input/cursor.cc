@@ -5,69 +5,170 @@
 #include "ozone/wayland/input/cursor.h"
 
 #include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-cursor.h>
+#include <algorithm>
 #include <vector>
 
+#include "base/hash.h"
 #include "base/logging.h"
 #include "base/memory/shared_memory.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/trace_event/trace_event.h"
 #include "ozone/wayland/display.h"
 
 namespace ozonewayland {
 
+namespace {
+
+// Cursors kept around after they were last shown. Pages rarely use more than
+// a handful of different cursors.
+const size_t kMaxCachedCursors = 16;
+// Enough for a few 64x64 cursors before the pool has to grow.
+const size_t kInitialPoolSize = 64 * 1024;
+
+}  // namespace
+
 WaylandCursor::WaylandCursor() : input_pointer_(NULL),
-    buffer_(NULL),
     sh_memory_(new base::SharedMemory()),
-    width_(0),
-    height_(0) {
+    pool_(NULL),
+    pool_size_(0),
+    pool_end_(0),
+    attached_buffer_(NULL),
+    buffer_scale_(1),
+    current_frame_(0),
+    frame_start_time_(0),
+    animation_paused_(false),
+    frame_callback_(NULL),
+    hits_(0),
+    misses_(0) {
   WaylandDisplay* display = WaylandDisplay::GetInstance();
   shm_ = display->GetShm();
   pointer_surface_ = wl_compositor_create_surface(display->GetCompositor());
 }
 
 WaylandCursor::~WaylandCursor() {
+  if (frame_callback_)
+    wl_callback_destroy(frame_callback_);
+
   wl_surface_destroy(pointer_surface_);
-  if (buffer_)
-    wl_buffer_destroy(buffer_);
+  for (CachedBufferList::iterator it = buffers_.begin();
+       it != buffers_.end(); ++it) {
+    wl_buffer_destroy((*it)->buffer);
+    delete *it;
+  }
+
+  if (pool_)
+    wl_shm_pool_destroy(pool_);
 
-  if (sh_memory_->handle().fd) {
-    sh_memory_->Unmap();
-    sh_memory_->Close();
+  if (hits_ + misses_) {
+    VLOG(1) << "WaylandCursor: " << hits_ << " cached cursor buffers used, "
+            << misses_ << " created ("
+            << hits_ * 100 / (hits_ + misses_) << "% hits)";
   }
-  delete sh_memory_;
 }
 
 void WaylandCursor::UpdateBitmap(const std::vector<SkBitmap>& cursor_image,
                                  const gfx::Point& location,
+                                 int frame_delay_ms,
                                  uint32_t serial) {
   if (!input_pointer_)
     return;
 
+  base::AutoLock lock(lock_);
+  frames_.clear();
+  current_frame_ = 0;
+  frame_start_time_ = 0;
   if (!cursor_image.size()) {
     HideCursor(serial);
     return;
   }
 
   const SkBitmap& image = cursor_image[0];
-  int width = image.width();
-  int height = image.height();
-  if (!width || !height) {
+  if (!image.width() || !image.height()) {
     HideCursor(serial);
     return;
   }
 
-  if (!CreateSHMBuffer(width, height)) {
+  // All frames are uploaded up front, so that the animation only flips
+  // between buffers.
+  uint32_t delay_ms = std::max(frame_delay_ms, 0);
+  for (size_t i = 0; i < cursor_image.size(); ++i) {
+    CachedBuffer* buffer = GetCachedBuffer(cursor_image[i]);
+    if (!buffer)
+      break;
+
+    Frame frame = {
+      buffer->buffer, buffer->width, buffer->height, delay_ms, buffer
+    };
+    frames_.push_back(frame);
+  }
+
+  if (frames_.empty()) {
     LOG(INFO) << "Failed to create SHM buffer for Cursor Bitmap.";
     wl_pointer_set_cursor(input_pointer_, serial, NULL, 0, 0);
     return;
   }
 
-  // The |bitmap| contains ARGB image, so just copy it.
-  memcpy(sh_memory_->memory(), image.getPixels(), width_ * height_ * 4);
+  ShowFramesLocked(location, 1, serial);
+}
 
+void WaylandCursor::UpdateThemeCursor(wl_cursor* cursor,
+                                      int scale,
+                                      uint32_t serial) {
+  if (!input_pointer_)
+    return;
+
+  base::AutoLock lock(lock_);
+  frames_.clear();
+  current_frame_ = 0;
+  frame_start_time_ = 0;
+  // The theme owns the buffers, they live as long as the theme.
+  for (unsigned i = 0; i < cursor->image_count; ++i) {
+    wl_cursor_image* image = cursor->images[i];
+    wl_buffer* buffer = wl_cursor_image_get_buffer(image);
+    if (!buffer)
+      break;
+
+    Frame frame = {
+      buffer,
+      static_cast<int>(image->width),
+      static_cast<int>(image->height),
+      image->delay,
+      NULL
+    };
+    frames_.push_back(frame);
+  }
+
+  if (frames_.empty()) {
+    HideCursor(serial);
+    return;
+  }
+
+  // The hotspot is in surface coordinates.
+  wl_cursor_image* image = cursor->images[0];
+  ShowFramesLocked(gfx::Point(image->hotspot_x / scale,
+                              image->hotspot_y / scale),
+                   scale,
+                   serial);
+}
+
+void WaylandCursor::ShowFramesLocked(const gfx::Point& hotspot,
+                                     int scale,
+                                     uint32_t serial) {
+  lock_.AssertAcquired();
   wl_pointer_set_cursor(input_pointer_, serial, pointer_surface_,
-                        location.x(), location.y());
-  wl_surface_attach(pointer_surface_, buffer_, 0, 0);
-  wl_surface_damage(pointer_surface_, 0, 0, width_, height_);
-  wl_surface_commit(pointer_surface_);
+                        hotspot.x(), hotspot.y());
+  bool scale_changed = scale != buffer_scale_;
+  if (scale_changed) {
+    wl_surface_set_buffer_scale(pointer_surface_, scale);
+    buffer_scale_ = scale;
+  }
+
+  if (scale_changed || frames_[0].buffer != attached_buffer_ ||
+      frames_.size() > 1) {
+    AttachBufferLocked(frames_[0]);
+  }
 }
 
 void WaylandCursor::MoveCursor(const gfx::Point& location, uint32_t serial) {
@@ -78,53 +179,278 @@ void WaylandCursor::MoveCursor(const gfx::Point& location, uint32_t serial) {
                          location.x(), location.y());
 }
 
-bool WaylandCursor::CreateSHMBuffer(int width, int height) {
-  if (width == width_ && height == height_)
+void WaylandCursor::PauseAnimation() {
+  base::AutoLock lock(lock_);
+  animation_paused_ = true;
+}
+
+void WaylandCursor::ResumeAnimation() {
+  base::AutoLock lock(lock_);
+  if (!animation_paused_)
+    return;
+
+  animation_paused_ = false;
+  if (frames_.size() > 1 && !frame_callback_) {
+    frame_start_time_ = 0;
+    RequestFrameLocked();
+    wl_surface_commit(pointer_surface_);
+  }
+}
+
+WaylandCursor::CachedBuffer* WaylandCursor::GetCachedBuffer(
+    const SkBitmap& image) {
+  // Bitmaps are deserialized from IPC, so their generation ids are new every
+  // time. Look them up by content instead.
+  uint32_t hash = base::Hash(static_cast<const char*>(image.getPixels()),
+                             image.getSize());
+  for (CachedBufferList::iterator it = buffers_.begin();
+       it != buffers_.end(); ++it) {
+    CachedBuffer* buffer = *it;
+    if (buffer->hash != hash || !MatchesImage(buffer, image))
+      continue;
+
+    buffers_.splice(buffers_.begin(), buffers_, it);
+    hits_++;
+    TRACE_COUNTER_ID2("ozone", "WaylandCursorBuffers", this,
+                      "hits", hits_, "misses", misses_);
+    return buffer;
+  }
+
+  misses_++;
+  TRACE_COUNTER_ID2("ozone", "WaylandCursorBuffers", this,
+                    "hits", hits_, "misses", misses_);
+  CachedBuffer* buffer = CreateCachedBuffer(image, hash);
+  if (!buffer)
+    return NULL;
+
+  buffers_.push_front(buffer);
+  EvictCachedBuffers();
+  return buffer;
+}
+
+WaylandCursor::CachedBuffer* WaylandCursor::CreateCachedBuffer(
+    const SkBitmap& image,
+    uint32_t hash) {
+  int stride = image.width() * 4;
+  size_t size = stride * image.height();
+  size_t offset;
+  if (!AllocateFromPool(size, &offset))
+    return NULL;
+
+  // The |image| contains ARGB rows, so just copy them.
+  uint8_t* pixels = static_cast<uint8_t*>(sh_memory_->memory()) + offset;
+  for (int y = 0; y < image.height(); ++y)
+    memcpy(pixels + y * stride, image.getAddr32(0, y), stride);
+
+  static const struct wl_buffer_listener kBufferListener = {
+    WaylandCursor::BufferRelease
+  };
+
+  CachedBuffer* buffer = new CachedBuffer;
+  buffer->hash = hash;
+  buffer->width = image.width();
+  buffer->height = image.height();
+  buffer->offset = offset;
+  buffer->size = size;
+  buffer->buffer = wl_shm_pool_create_buffer(pool_, offset,
+                                             image.width(), image.height(),
+                                             stride, WL_SHM_FORMAT_ARGB8888);
+  buffer->busy = 0;
+  wl_buffer_add_listener(buffer->buffer, &kBufferListener, buffer);
+  return buffer;
+}
+
+bool WaylandCursor::MatchesImage(const CachedBuffer* buffer,
+                                 const SkBitmap& image) const {
+  if (buffer->width != image.width() || buffer->height != image.height())
+    return false;
+
+  int stride = buffer->width * 4;
+  const uint8_t* pixels =
+      static_cast<const uint8_t*>(sh_memory_->memory()) + buffer->offset;
+  for (int y = 0; y < buffer->height; ++y) {
+    if (memcmp(pixels + y * stride, image.getAddr32(0, y), stride))
+      return false;
+  }
+
+  return true;
+}
+
+void WaylandCursor::EvictCachedBuffers() {
+  // Least recently used first. Buffers the compositor may still read from
+  // stay until they are released.
+  lock_.AssertAcquired();
+  CachedBufferList::iterator it = buffers_.end();
+  while (buffers_.size() > kMaxCachedCursors && it != buffers_.begin()) {
+    --it;
+    CachedBuffer* buffer = *it;
+    if (buffer->buffer == attached_buffer_ ||
+        base::subtle::NoBarrier_Load(&buffer->busy) ||
+        IsCurrentFrameLocked(buffer)) {
+      continue;
+    }
+
+    it = buffers_.erase(it);
+    DestroyCachedBuffer(buffer);
+  }
+}
+
+bool WaylandCursor::IsCurrentFrameLocked(const CachedBuffer* buffer) const {
+  for (size_t i = 0; i < frames_.size(); ++i) {
+    if (frames_[i].cached == buffer)
+      return true;
+  }
+
+  return false;
+}
+
+void WaylandCursor::DestroyCachedBuffer(CachedBuffer* buffer) {
+  wl_buffer_destroy(buffer->buffer);
+  FreeToPool(buffer->offset, buffer->size);
+  delete buffer;
+}
+
+bool WaylandCursor::AllocateFromPool(size_t size, size_t* offset) {
+  for (std::map<size_t, size_t>::iterator it = free_ranges_.begin();
+       it != free_ranges_.end(); ++it) {
+    if (it->second < size)
+      continue;
+
+    *offset = it->first;
+    if (it->second > size)
+      free_ranges_[it->first + size] = it->second - size;
+    free_ranges_.erase(it);
     return true;
+  }
+
+  if (pool_end_ + size > pool_size_ && !GrowPool(pool_end_ + size))
+    return false;
+
+  *offset = pool_end_;
+  pool_end_ += size;
+  return true;
+}
+
+void WaylandCursor::FreeToPool(size_t offset, size_t size) {
+  std::map<size_t, size_t>::iterator next = free_ranges_.lower_bound(offset);
+  // Merge with the ranges right after and before, so that freed memory
+  // doesn't end up in pieces too small for any cursor.
+  if (next != free_ranges_.end() && offset + size == next->first) {
+    size += next->second;
+    free_ranges_.erase(next++);
+  }
+
+  if (next != free_ranges_.begin()) {
+    std::map<size_t, size_t>::iterator previous = next;
+    --previous;
+    if (previous->first + previous->second == offset) {
+      offset = previous->first;
+      size += previous->second;
+      free_ranges_.erase(previous);
+    }
+  }
 
-  struct wl_shm_pool *pool;
-  int size, stride;
+  if (offset + size == pool_end_)
+    pool_end_ = offset;
+  else
+    free_ranges_[offset] = size;
+}
+
+bool WaylandCursor::GrowPool(size_t min_size) {
+  size_t size = std::max(std::max(pool_size_ * 2, kInitialPoolSize), min_size);
+  if (!pool_) {
+    if (!sh_memory_->CreateAndMapAnonymous(size)) {
+      LOG(INFO) << "Create and mmap failed.";
+      return false;
+    }
 
-  width_ = width;
-  height_ = height;
-  stride = width_ * 4;
-  SkImageInfo info = SkImageInfo::MakeN32Premul(width_, height_);
-  size = info.getSafeSize(stride);
+    pool_ = wl_shm_create_pool(shm_, sh_memory_->handle().fd, size);
+    pool_size_ = size;
+    return true;
+  }
 
-  if (sh_memory_->handle().fd) {
-    sh_memory_->Unmap();
-    sh_memory_->Close();
+  // Buffers already created keep their offsets, only the mapping changes.
+  if (HANDLE_EINTR(ftruncate(sh_memory_->handle().fd, size)) < 0) {
+    PLOG(ERROR) << "Failed to grow cursor shm pool";
+    return false;
   }
 
-  if (!sh_memory_->CreateAndMapAnonymous(size)) {
-    LOG(INFO) << "Create and mmap failed.";
+  sh_memory_->Unmap();
+  if (!sh_memory_->Map(size)) {
+    LOG(ERROR) << "Failed to map cursor shm pool";
+    // Cached buffers are still backed by the old size.
+    CHECK(sh_memory_->Map(pool_size_));
     return false;
   }
 
-  pool = wl_shm_create_pool(shm_,
-                            sh_memory_->handle().fd,
-                            size);
-  buffer_ = wl_shm_pool_create_buffer(pool, 0,
-                                      width_, height_,
-                                      stride, WL_SHM_FORMAT_ARGB8888);
-  wl_shm_pool_destroy(pool);
+  wl_shm_pool_resize(pool_, size);
+  pool_size_ = size;
   return true;
 }
 
 void WaylandCursor::HideCursor(uint32_t serial) {
-  width_ = 0;
-  height_ = 0;
   wl_pointer_set_cursor(input_pointer_, serial, NULL, 0, 0);
+}
 
-  if (buffer_) {
-    wl_buffer_destroy(buffer_);
-    buffer_ = NULL;
+void WaylandCursor::AttachBufferLocked(const Frame& frame) {
+  lock_.AssertAcquired();
+  if (frames_.size() > 1 && !animation_paused_)
+    RequestFrameLocked();
+
+  if (frame.buffer != attached_buffer_) {
+    wl_surface_attach(pointer_surface_, frame.buffer, 0, 0);
+    wl_surface_damage(pointer_surface_, 0, 0, frame.width, frame.height);
+    if (frame.cached)
+      base::subtle::NoBarrier_Store(&frame.cached->busy, 1);
+    attached_buffer_ = frame.buffer;
   }
 
-  if (sh_memory_->handle().fd) {
-    sh_memory_->Unmap();
-    sh_memory_->Close();
+  wl_surface_commit(pointer_surface_);
+}
+
+void WaylandCursor::RequestFrameLocked() {
+  static const struct wl_callback_listener kFrameListener = {
+    WaylandCursor::FrameCallback
+  };
+
+  lock_.AssertAcquired();
+  if (frame_callback_)
+    return;
+
+  frame_callback_ = wl_surface_frame(pointer_surface_);
+  wl_callback_add_listener(frame_callback_, &kFrameListener, this);
+}
+
+// static
+void WaylandCursor::FrameCallback(void* data,
+                                  wl_callback* callback,
+                                  uint32_t time) {
+  WaylandCursor* cursor = static_cast<WaylandCursor*>(data);
+  base::AutoLock lock(cursor->lock_);
+  DCHECK_EQ(cursor->frame_callback_, callback);
+  wl_callback_destroy(callback);
+  cursor->frame_callback_ = NULL;
+  // The animation stops with the cursor being changed or hidden, or the
+  // pointer leaving.
+  if (cursor->frames_.size() < 2 || cursor->animation_paused_)
+    return;
+
+  if (!cursor->frame_start_time_) {
+    cursor->frame_start_time_ = time;
+  } else if (time - cursor->frame_start_time_ >=
+             cursor->frames_[cursor->current_frame_].delay_ms) {
+    cursor->current_frame_ =
+        (cursor->current_frame_ + 1) % cursor->frames_.size();
+    cursor->frame_start_time_ = time;
   }
+
+  cursor->AttachBufferLocked(cursor->frames_[cursor->current_frame_]);
+}
+
+// static
+void WaylandCursor::BufferRelease(void* data, wl_buffer* buffer) {
+  CachedBuffer* cached_buffer = static_cast<CachedBuffer*>(data);
+  base::subtle::NoBarrier_Store(&cached_buffer->busy, 0);
 }
 
 void WaylandCursor::SetInputPointer(wl_pointer* pointer) {
@@ -6,11 +6,18 @@
 #define OZONE_WAYLAND_INPUT_CURSOR_H_
 
 #include <wayland-client.h>
+#include <list>
+#include <map>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 
+struct wl_cursor;
+
 namespace base {
 class SharedMemory;
 }
@@ -21,30 +28,116 @@ class Point;
 
 namespace ozonewayland {
 
+// Shows cursor images on a cursor surface of the pointer. Every distinct
+// image gets its own wl_buffer, carved from one shm pool shared by all of
+// them, and is kept for when the cursor changes back to it. Switching between
+// cursors seen before is only an attach.
+//
+// Standard cursors are shown from the buffers of the cursor theme instead.
+//
+// Cursors with several images are animated from frame callbacks of the cursor
+// surface, which are dispatched on the thread dispatching Wayland events, by
+// attaching the buffers of the frames in turn.
 class WaylandCursor {
  public:
   WaylandCursor();
   ~WaylandCursor();
 
+  // Shows |bitmaps| with the hotspot at |location|, each one for
+  // |frame_delay_ms| if there is more than one.
   void UpdateBitmap(const std::vector<SkBitmap>& bitmaps,
                     const gfx::Point& location,
+                    int frame_delay_ms,
                     uint32_t serial);
+  // Shows |cursor| from the cursor theme, whose images are |scale| times the
+  // size of the surface.
+  void UpdateThemeCursor(wl_cursor* cursor, int scale, uint32_t serial);
   void MoveCursor(const gfx::Point& location, uint32_t serial);
+  // Stops animating while the pointer is outside of our surfaces. Called on
+  // the thread dispatching pointer events.
+  void PauseAnimation();
+  void ResumeAnimation();
 
   wl_pointer* GetInputPointer() const { return input_pointer_; }
   void SetInputPointer(wl_pointer* pointer);
 
  private:
-  bool CreateSHMBuffer(int width, int height);
+  // A cursor image in the shm pool.
+  struct CachedBuffer {
+    uint32_t hash;
+    int width;
+    int height;
+    size_t offset;
+    size_t size;
+    wl_buffer* buffer;
+    // Set while the buffer is attached to the cursor surface, cleared by the
+    // compositor releasing it on the thread dispatching Wayland events. The
+    // memory of a busy buffer can't be reused.
+    base::subtle::Atomic32 busy;
+  };
+
+  // An image of the current cursor.
+  struct Frame {
+    wl_buffer* buffer;
+    int width;
+    int height;
+    uint32_t delay_ms;
+    // NULL for buffers of the cursor theme.
+    CachedBuffer* cached;
+  };
+
+  typedef std::list<CachedBuffer*> CachedBufferList;
+
+  // Returns the buffer showing |image|, creating it if it isn't cached.
+  CachedBuffer* GetCachedBuffer(const SkBitmap& image);
+  CachedBuffer* CreateCachedBuffer(const SkBitmap& image, uint32_t hash);
+  bool MatchesImage(const CachedBuffer* buffer, const SkBitmap& image) const;
+  void EvictCachedBuffers();
+  void DestroyCachedBuffer(CachedBuffer* buffer);
+  // Hands out |size| bytes of the pool, growing it if needed.
+  bool AllocateFromPool(size_t size, size_t* offset);
+  void FreeToPool(size_t offset, size_t size);
+  bool GrowPool(size_t min_size);
+  // Shows |frames_| with the hotspot at |hotspot| in surface coordinates.
+  void ShowFramesLocked(const gfx::Point& hotspot, int scale, uint32_t serial);
+  bool IsCurrentFrameLocked(const CachedBuffer* buffer) const;
   void HideCursor(uint32_t serial);
+  // Attaches the buffer of |frame| to the cursor surface and commits it, along
+  // with a frame callback if the cursor is animated.
+  void AttachBufferLocked(const Frame& frame);
+  void RequestFrameLocked();
+
+  static void BufferRelease(void* data, wl_buffer* buffer);
+  static void FrameCallback(void* data, wl_callback* callback, uint32_t time);
 
   struct wl_pointer* input_pointer_;
   struct wl_surface* pointer_surface_;
-  struct wl_buffer* buffer_;
   struct wl_shm* shm_;
-  base::SharedMemory* sh_memory_;
-  int width_;
-  int height_;
+  scoped_ptr<base::SharedMemory> sh_memory_;
+  struct wl_shm_pool* pool_;
+  size_t pool_size_;
+  // Memory past |pool_end_| has never been handed out.
+  size_t pool_end_;
+  // Sizes of the freed ranges below |pool_end_|, by offset.
+  std::map<size_t, size_t> free_ranges_;
+  // Most recently used first.
+  CachedBufferList buffers_;
+  // Protects the state below, which is also used by FrameCallback().
+  base::Lock lock_;
+  // Buffer currently attached to |pointer_surface_|.
+  wl_buffer* attached_buffer_;
+  int buffer_scale_;
+  // Images of the current cursor, more than one if it is animated. Their
+  // cached buffers aren't evicted while in use.
+  std::vector<Frame> frames_;
+  size_t current_frame_;
+  // Compositor time the current frame was first seen in a frame callback, 0
+  // until then.
+  uint32_t frame_start_time_;
+  bool animation_paused_;
+  wl_callback* frame_callback_;
+  uint64_t hits_;
+  uint64_t misses_;
   DISALLOW_COPY_AND_ASSIGN(WaylandCursor);
 };
 
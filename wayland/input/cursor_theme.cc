@@ -0,0 +1,135 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/input/cursor_theme.h"
+
+#include <stdlib.h>
+#include <wayland-cursor.h>
+
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+
+namespace ozonewayland {
+
+namespace {
+
+// Same default as libXcursor.
+const int kDefaultCursorSize = 24;
+
+// Cursor names by ui::WaylandCursorType, CSS names first, then the X11 core
+// names older themes use.
+const char* const kCursorNames[][3] = {
+  { NULL, NULL, NULL },  // CURSOR_NONE
+  { "left_ptr", "default", NULL },
+  { "crosshair", "cross", NULL },
+  { "hand2", "pointer", "hand1" },
+  { "xterm", "text", "ibeam" },
+  { "watch", "wait", NULL },
+  { "question_arrow", "help", NULL },
+  { "left_ptr_watch", "progress", "watch" },
+  { "fleur", "move", "all-scroll" },
+  { "vertical-text", NULL, NULL },
+  { "cell", "plus", NULL },
+  { "context-menu", NULL, NULL },
+  { "alias", "link", "dnd-link" },
+  { "copy", "dnd-copy", NULL },
+  { "no-drop", "dnd-no-drop", NULL },
+  { "not-allowed", "crossed_circle", "circle" },
+  { "zoom-in", NULL, NULL },
+  { "zoom-out", NULL, NULL },
+  { "grab", "openhand", "hand1" },
+  { "grabbing", "closedhand", "fleur" },
+  { "top_side", "n-resize", NULL },
+  { "top_right_corner", "ne-resize", NULL },
+  { "right_side", "e-resize", NULL },
+  { "bottom_right_corner", "se-resize", NULL },
+  { "bottom_side", "s-resize", NULL },
+  { "bottom_left_corner", "sw-resize", NULL },
+  { "left_side", "w-resize", NULL },
+  { "top_left_corner", "nw-resize", NULL },
+  { "sb_v_double_arrow", "ns-resize", NULL },
+  { "sb_h_double_arrow", "ew-resize", NULL },
+  { "fd_double_arrow", "nesw-resize", "size_bdiag" },
+  { "bd_double_arrow", "nwse-resize", "size_fdiag" },
+  { "col-resize", "sb_h_double_arrow", NULL },
+  { "row-resize", "sb_v_double_arrow", NULL },
+};
+
+static_assert(arraysize(kCursorNames) == ui::CURSOR_TYPE_LAST + 1,
+              "kCursorNames doesn't match ui::WaylandCursorType");
+
+}  // namespace
+
+WaylandCursorTheme::WaylandCursorTheme(wl_shm* shm)
+    : shm_(shm),
+      size_(kDefaultCursorSize) {
+  // The variables compositors and toolkits agree on for the cursor theme.
+  const char* name = getenv("XCURSOR_THEME");
+  if (name)
+    name_ = name;
+
+  const char* size = getenv("XCURSOR_SIZE");
+  int parsed_size;
+  if (size && base::StringToInt(size, &parsed_size) && parsed_size > 0)
+    size_ = parsed_size;
+}
+
+WaylandCursorTheme::~WaylandCursorTheme() {
+  for (std::map<int, wl_cursor_theme*>::iterator it = themes_.begin();
+       it != themes_.end(); ++it) {
+    if (it->second)
+      wl_cursor_theme_destroy(it->second);
+  }
+}
+
+uint64_t WaylandCursorTheme::GetAvailableTypes() {
+  static_assert(ui::CURSOR_TYPE_LAST < 64,
+                "ui::WaylandCursorType doesn't fit into the type mask");
+  uint64_t types = 0;
+  for (int type = ui::CURSOR_NONE + 1; type <= ui::CURSOR_TYPE_LAST; ++type) {
+    if (GetCursor(static_cast<ui::WaylandCursorType>(type), 1))
+      types |= static_cast<uint64_t>(1) << type;
+  }
+  return types;
+}
+
+wl_cursor* WaylandCursorTheme::GetCursor(ui::WaylandCursorType type,
+                                         int scale) {
+  if (type <= ui::CURSOR_NONE || type > ui::CURSOR_TYPE_LAST)
+    return NULL;
+
+  wl_cursor_theme* theme = GetTheme(scale);
+  if (!theme)
+    return NULL;
+
+  for (size_t i = 0; i < arraysize(kCursorNames[type]); ++i) {
+    if (!kCursorNames[type][i])
+      break;
+
+    wl_cursor* cursor = wl_cursor_theme_get_cursor(theme,
+                                                   kCursorNames[type][i]);
+    if (cursor)
+      return cursor;
+  }
+
+  return NULL;
+}
+
+wl_cursor_theme* WaylandCursorTheme::GetTheme(int scale) {
+  std::map<int, wl_cursor_theme*>::const_iterator it = themes_.find(scale);
+  if (it != themes_.end())
+    return it->second;
+
+  // Failures are remembered too, so that the theme isn't searched for on
+  // every cursor change.
+  wl_cursor_theme* theme = wl_cursor_theme_load(
+      name_.empty() ? NULL : name_.c_str(), size_ * scale, shm_);
+  if (!theme)
+    LOG(WARNING) << "Failed to load cursor theme at scale " << scale;
+
+  themes_[scale] = theme;
+  return theme;
+}
+
+}  // namespace ozonewayland
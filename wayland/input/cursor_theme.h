@@ -0,0 +1,52 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_INPUT_CURSOR_THEME_H_
+#define OZONE_WAYLAND_INPUT_CURSOR_THEME_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "ozone/platform/window_constants.h"
+
+struct wl_cursor;
+struct wl_cursor_theme;
+struct wl_shm;
+
+namespace ozonewayland {
+
+// Standard cursors from the system cursor theme, as used by the compositor
+// and other clients. The images of a theme live in one shm pool owned by
+// libwayland-cursor, shared by all cursor surfaces, so nothing is uploaded
+// when a standard cursor is shown. Themes are loaded once per output scale
+// and kept until the display goes away, their buffers stay valid as long.
+class WaylandCursorTheme {
+ public:
+  explicit WaylandCursorTheme(wl_shm* shm);
+  ~WaylandCursorTheme();
+
+  // Returns a mask with bit N set if the theme has the cursor for the
+  // ui::WaylandCursorType N. Cursors are looked up by the same names at every
+  // scale.
+  uint64_t GetAvailableTypes();
+  // Returns the cursor for |type| with images for |scale|, NULL if the theme
+  // doesn't have it.
+  wl_cursor* GetCursor(ui::WaylandCursorType type, int scale);
+
+ private:
+  wl_cursor_theme* GetTheme(int scale);
+
+  wl_shm* shm_;
+  std::string name_;
+  int size_;
+  std::map<int, wl_cursor_theme*> themes_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandCursorTheme);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_INPUT_CURSOR_THEME_H_
@@ -22,6 +22,9 @@ void WaylandKeyboard::OnSeatCapabilities(wl_seat *seat, uint32_t caps) {
     WaylandKeyboard::OnKeyboardLeave,
     WaylandKeyboard::OnKeyNotify,
     WaylandKeyboard::OnKeyModifiers,
+#if defined(WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION)
+    WaylandKeyboard::OnRepeatInfo,
+#endif
   };
 
   dispatcher_ =
@@ -95,4 +98,13 @@ void WaylandKeyboard::OnKeyModifiers(void *data,
                                      uint32_t group) {
 }
 
+#if defined(WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION)
+void WaylandKeyboard::OnRepeatInfo(void* data,
+                                   wl_keyboard* keyboard,
+                                   int32_t rate,
+                                   int32_t delay) {
+  // Keys are repeated by the keyboard state in the browser.
+}
+#endif
+
 }  // namespace ozonewayland
@@ -49,6 +49,13 @@ class WaylandKeyboard {
                              uint32_t mods_locked,
                              uint32_t group);
 
+#if defined(WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION)
+  static void OnRepeatInfo(void* data,
+                           wl_keyboard* keyboard,
+                           int32_t rate,
+                           int32_t delay);
+#endif
+
   wl_keyboard* input_keyboard_;
   WaylandDisplay* dispatcher_;
 
@@ -13,11 +13,35 @@
 
 namespace ozonewayland {
 
+namespace {
+
+// Compositors send 10 units of axis value per wheel click.
+const float kAxisValuePerWheelClick = 10;
+// Finger scrolling this recent makes up the velocity of a fling.
+const uint32_t kFlingVelocityWindowMs = 100;
+
+float AxisValueToWheelOffset(float value) {
+  return -value * ui::MouseWheelEvent::kWheelDelta / kAxisValuePerWheelClick;
+}
+
+}  // namespace
+
+WaylandPointer::AxisFrame::AxisFrame()
+    : has_source(false),
+      source(0),
+      discrete_x(0),
+      discrete_y(0),
+      stop(false),
+      time(0) {
+}
+
 WaylandPointer::WaylandPointer()
   : cursor_(NULL),
     dispatcher_(NULL),
     pointer_position_(0, 0),
-    input_pointer_(NULL) {
+    input_pointer_(NULL),
+    has_frames_(false),
+    fling_started_(false) {
 }
 
 WaylandPointer::~WaylandPointer() {
@@ -33,6 +57,12 @@ void WaylandPointer::OnSeatCapabilities(wl_seat *seat, uint32_t caps) {
     WaylandPointer::OnMotionNotify,
     WaylandPointer::OnButtonNotify,
     WaylandPointer::OnAxisNotify,
+#if defined(WL_POINTER_FRAME_SINCE_VERSION)
+    WaylandPointer::OnFrame,
+    WaylandPointer::OnAxisSource,
+    WaylandPointer::OnAxisStop,
+    WaylandPointer::OnAxisDiscrete,
+#endif
   };
 
   if (!cursor_)
@@ -45,6 +75,10 @@ void WaylandPointer::OnSeatCapabilities(wl_seat *seat, uint32_t caps) {
       cursor_->SetInputPointer(input_pointer_);
     wl_pointer_set_user_data(input_pointer_, this);
     wl_pointer_add_listener(input_pointer_, &kInputPointerListener, this);
+#if defined(WL_POINTER_FRAME_SINCE_VERSION)
+    has_frames_ = wl_pointer_get_version(input_pointer_) >=
+                  WL_POINTER_FRAME_SINCE_VERSION;
+#endif
   }
 }
 
@@ -64,7 +98,7 @@ void WaylandPointer::OnMotionNotify(void* data,
       return;
   }
 
-  device->dispatcher_->MotionNotify(sx, sy);
+  device->dispatcher_->MotionNotify(sx, sy, time);
 }
 
 void WaylandPointer::OnButtonNotify(void* data,
@@ -98,7 +132,8 @@ void WaylandPointer::OnButtonNotify(void* data,
                                       type,
                                       flags,
                                       device->pointer_position_.x(),
-                                      device->pointer_position_.y());
+                                      device->pointer_position_.y(),
+                                      time);
   }
 
   if (seat->GetGrabWindowHandle() && seat->GetGrabButton() == button &&
@@ -111,16 +146,29 @@ void WaylandPointer::OnAxisNotify(void* data,
                                   uint32_t time,
                                   uint32_t axis,
                                   int32_t value) {
-  int x_offset = 0, y_offset = 0;
   WaylandPointer* device = static_cast<WaylandPointer*>(data);
-  const int delta = ui::MouseWheelEvent::kWheelDelta;
+  float delta = wl_fixed_to_double(value);
+#if defined(WL_POINTER_FRAME_SINCE_VERSION)
+  if (device->has_frames_) {
+    AxisFrame& frame = device->axis_frame_;
+    if (axis == WL_POINTER_AXIS_HORIZONTAL_SCROLL)
+      frame.delta.set_x(frame.delta.x() + delta);
+    else if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL)
+      frame.delta.set_y(frame.delta.y() + delta);
+    frame.time = time;
+    return;
+  }
+#endif
 
+  // Without frames there is no telling touchpads from wheels, so scroll by
+  // the amount the compositor asks for instead of whole wheel clicks.
+  float x_offset = 0, y_offset = 0;
   switch (axis) {
     case WL_POINTER_AXIS_HORIZONTAL_SCROLL:
-      x_offset = value > 0 ? -delta : delta;
+      x_offset = AxisValueToWheelOffset(delta);
       break;
     case WL_POINTER_AXIS_VERTICAL_SCROLL:
-      y_offset = value > 0 ? -delta : delta;
+      y_offset = AxisValueToWheelOffset(delta);
       break;
     default:
       break;
@@ -129,9 +177,121 @@ void WaylandPointer::OnAxisNotify(void* data,
   device->dispatcher_->AxisNotify(device->pointer_position_.x(),
                                   device->pointer_position_.y(),
                                   x_offset,
-                                  y_offset);
+                                  y_offset,
+                                  time);
 }
 
+#if defined(WL_POINTER_FRAME_SINCE_VERSION)
+void WaylandPointer::OnFrame(void* data, wl_pointer* input_pointer) {
+  WaylandPointer* device = static_cast<WaylandPointer*>(data);
+  device->FlushAxisFrame();
+}
+
+void WaylandPointer::OnAxisSource(void* data,
+                                  wl_pointer* input_pointer,
+                                  uint32_t axis_source) {
+  WaylandPointer* device = static_cast<WaylandPointer*>(data);
+  device->axis_frame_.has_source = true;
+  device->axis_frame_.source = axis_source;
+}
+
+void WaylandPointer::OnAxisStop(void* data,
+                                wl_pointer* input_pointer,
+                                uint32_t time,
+                                uint32_t axis) {
+  WaylandPointer* device = static_cast<WaylandPointer*>(data);
+  device->axis_frame_.stop = true;
+  device->axis_frame_.time = time;
+}
+
+void WaylandPointer::OnAxisDiscrete(void* data,
+                                    wl_pointer* input_pointer,
+                                    uint32_t axis,
+                                    int32_t discrete) {
+  WaylandPointer* device = static_cast<WaylandPointer*>(data);
+  if (axis == WL_POINTER_AXIS_HORIZONTAL_SCROLL)
+    device->axis_frame_.discrete_x += discrete;
+  else if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL)
+    device->axis_frame_.discrete_y += discrete;
+}
+
+void WaylandPointer::FlushAxisFrame() {
+  AxisFrame frame = axis_frame_;
+  axis_frame_ = AxisFrame();
+  bool has_delta = !frame.delta.IsZero();
+  if (!has_delta && !frame.stop)
+    return;
+
+  float x = pointer_position_.x();
+  float y = pointer_position_.y();
+  bool finger = frame.has_source &&
+                frame.source == WL_POINTER_AXIS_SOURCE_FINGER;
+  bool continuous = frame.has_source &&
+                    frame.source == WL_POINTER_AXIS_SOURCE_CONTINUOUS;
+  if (!finger && !continuous) {
+    // Wheels, or sources the compositor didn't tell.
+    if (!has_delta)
+      return;
+
+    float x_offset = frame.discrete_x ?
+        -frame.discrete_x * ui::MouseWheelEvent::kWheelDelta :
+        AxisValueToWheelOffset(frame.delta.x());
+    float y_offset = frame.discrete_y ?
+        -frame.discrete_y * ui::MouseWheelEvent::kWheelDelta :
+        AxisValueToWheelOffset(frame.delta.y());
+    dispatcher_->AxisNotify(x, y, x_offset, y_offset, frame.time);
+    return;
+  }
+
+  // One precise scroll per frame, however many axis events it had.
+  if (has_delta) {
+    if (fling_started_) {
+      dispatcher_->ScrollNotify(ui::ET_SCROLL_FLING_CANCEL, x, y, 0, 0,
+                                frame.time);
+      fling_started_ = false;
+    }
+
+    dispatcher_->ScrollNotify(ui::ET_SCROLL, x, y, -frame.delta.x(),
+                              -frame.delta.y(), frame.time);
+    if (finger) {
+      ScrollSample sample = { frame.time, frame.delta };
+      scroll_samples_.push_back(sample);
+      while (frame.time - scroll_samples_.front().time >
+             kFlingVelocityWindowMs) {
+        scroll_samples_.pop_front();
+      }
+    }
+  }
+
+  // The fingers left the touchpad. A fling without velocity still tells
+  // that the scroll ended.
+  if (finger && frame.stop) {
+    gfx::Vector2dF velocity = GetScrollVelocity();
+    dispatcher_->ScrollNotify(ui::ET_SCROLL_FLING_START, x, y, -velocity.x(),
+                              -velocity.y(), frame.time);
+    scroll_samples_.clear();
+    fling_started_ = true;
+  }
+}
+
+gfx::Vector2dF WaylandPointer::GetScrollVelocity() const {
+  if (scroll_samples_.size() < 2)
+    return gfx::Vector2dF();
+
+  uint32_t duration_ms =
+      scroll_samples_.back().time - scroll_samples_.front().time;
+  if (!duration_ms)
+    return gfx::Vector2dF();
+
+  // The first sample only marks the start of the window.
+  gfx::Vector2dF distance;
+  for (size_t i = 1; i < scroll_samples_.size(); ++i)
+    distance += scroll_samples_[i].delta;
+  distance.Scale(1000.f / duration_ms);
+  return distance;
+}
+#endif
+
 void WaylandPointer::OnPointerEnter(void* data,
                                     wl_pointer* input_pointer,
                                     uint32_t serial,
@@ -154,6 +314,7 @@ void WaylandPointer::OnPointerEnter(void* data,
 
   WaylandDisplay::GetInstance()->SetSerial(serial);
   device->pointer_position_.SetPoint(sx, sy);
+  device->cursor_->ResumeAnimation();
   seat->SetFocusWindowHandle(handle);
   device->dispatcher_->PointerEnter(handle,
                                     device->pointer_position_.x(),
@@ -166,6 +327,11 @@ void WaylandPointer::OnPointerLeave(void* data,
                                     wl_surface* surface) {
   WaylandPointer* device = static_cast<WaylandPointer*>(data);
   WaylandDisplay::GetInstance()->SetSerial(serial);
+  device->cursor_->PauseAnimation();
+
+  // Scrolling doesn't carry over to the next surface.
+  device->scroll_samples_.clear();
+  device->fling_started_ = false;
 
   WaylandSeat* seat = WaylandDisplay::GetInstance()->PrimarySeat();
   device->dispatcher_->PointerLeave(seat->GetFocusWindowHandle(),
@@ -5,8 +5,11 @@
 #ifndef OZONE_WAYLAND_INPUT_POINTER_H_
 #define OZONE_WAYLAND_INPUT_POINTER_H_
 
+#include <deque>
+
 #include "ozone/wayland/display.h"
 #include "ui/gfx/geometry/point.h"
+#include "ui/gfx/geometry/vector2d_f.h"
 
 namespace ozonewayland {
 
@@ -44,6 +47,32 @@ class WaylandPointer {
       uint32_t axis,
       int32_t value);
 
+#if defined(WL_POINTER_FRAME_SINCE_VERSION)
+  static void OnFrame(void* data, wl_pointer* input_pointer);
+
+  static void OnAxisSource(
+      void* data,
+      wl_pointer* input_pointer,
+      uint32_t axis_source);
+
+  static void OnAxisStop(
+      void* data,
+      wl_pointer* input_pointer,
+      uint32_t time,
+      uint32_t axis);
+
+  static void OnAxisDiscrete(
+      void* data,
+      wl_pointer* input_pointer,
+      uint32_t axis,
+      int32_t discrete);
+
+  // Sends the scrolling of the current frame as one event.
+  void FlushAxisFrame();
+  // Velocity of the recent finger scrolling in pixels per second.
+  gfx::Vector2dF GetScrollVelocity() const;
+#endif
+
   static void OnPointerEnter(
       void* data,
       wl_pointer* input_pointer,
@@ -65,6 +94,34 @@ class WaylandPointer {
   // position associated on Wayland.
   gfx::Point pointer_position_;
   struct wl_pointer *input_pointer_;
+  // Whether axis events are grouped by frame events, i.e. the seat is bound
+  // at version 5 or later. Otherwise every axis event is sent on its own.
+  bool has_frames_;
+
+  // Axis events received since the last frame event.
+  struct AxisFrame {
+    AxisFrame();
+
+    bool has_source;
+    uint32_t source;
+    // Surface pixels, positive when scrolling down or right.
+    gfx::Vector2dF delta;
+    // Wheel clicks, only sent by wheels.
+    int discrete_x;
+    int discrete_y;
+    bool stop;
+    uint32_t time;
+  };
+  AxisFrame axis_frame_;
+
+  struct ScrollSample {
+    uint32_t time;
+    gfx::Vector2dF delta;
+  };
+  // Finger scrolling of the last frames, for the fling velocity.
+  std::deque<ScrollSample> scroll_samples_;
+  // Set after a fling was started, until scrolling is resumed.
+  bool fling_started_;
 
   DISALLOW_COPY_AND_ASSIGN(WaylandPointer);
 };
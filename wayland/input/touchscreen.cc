@@ -116,7 +116,9 @@ void WaylandTouchscreen::OnTouchMotion(void *data,
 
 void WaylandTouchscreen::OnTouchFrame(void *data,
                                       struct wl_touch *wl_touch) {
-  // TODO(speedpat): find out what should be done here
+  // All touch points of a frame have been sent, deliver them together.
+  WaylandTouchscreen* device = static_cast<WaylandTouchscreen*>(data);
+  device->dispatcher_->FlushInputEvents();
 }
 
 void WaylandTouchscreen::OnTouchCancel(void *data,
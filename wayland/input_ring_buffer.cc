@@ -0,0 +1,177 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/input_ring_buffer.h"
+
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+
+namespace ozonewayland {
+
+// Indices count all records ever written or read and wrap around at 2^32,
+// the slot of a record is its index modulo the capacity. Each index is only
+// ever written by one side, so they are kept on separate cache lines.
+struct WaylandInputRingBuffer::Header {
+  base::subtle::Atomic32 write_index;
+  char padding1[60];
+  base::subtle::Atomic32 read_index;
+  char padding2[60];
+};
+
+namespace {
+
+bool IsValidEvent(const ui::WaylandInputEvent& event) {
+  return event.type >= ui::WaylandInputEvent::MOTION &&
+         event.type <= ui::WaylandInputEvent::SCROLL &&
+         event.event_type >= ui::ET_UNKNOWN &&
+         event.event_type <= ui::ET_LAST;
+}
+
+}  // namespace
+
+WaylandInputRingBuffer::WaylandInputRingBuffer()
+    : size_(0),
+      capacity_(0),
+      doorbell_fd_(-1) {
+}
+
+WaylandInputRingBuffer::~WaylandInputRingBuffer() {
+  if (doorbell_fd_ >= 0)
+    close(doorbell_fd_);
+}
+
+bool WaylandInputRingBuffer::Create(size_t capacity) {
+  DCHECK(!capacity_);
+  uint32_t records = 1;
+  while (records < capacity)
+    records <<= 1;
+
+  size_ = sizeof(Header) + records * sizeof(ui::WaylandInputEvent);
+  shared_memory_.reset(new base::SharedMemory());
+  if (!shared_memory_->CreateAndMapAnonymous(size_)) {
+    LOG(ERROR) << "Failed to create shared memory for the input ring.";
+    return false;
+  }
+
+  doorbell_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (doorbell_fd_ < 0) {
+    LOG(ERROR) << "Failed to create the input ring doorbell.";
+    return false;
+  }
+
+  memset(shared_memory_->memory(), 0, sizeof(Header));
+  capacity_ = records;
+  return true;
+}
+
+bool WaylandInputRingBuffer::Map(base::SharedMemoryHandle handle,
+                                 size_t size,
+                                 base::FileDescriptor doorbell) {
+  DCHECK(!capacity_);
+  doorbell_fd_ = doorbell.fd;
+  shared_memory_.reset(new base::SharedMemory(handle, false));
+  size_t records = 0;
+  if (size > sizeof(Header))
+    records = (size - sizeof(Header)) / sizeof(ui::WaylandInputEvent);
+
+  // The size comes from the GPU process, validate it before using it. A
+  // shorter file would fault on the first read of a record beyond its end.
+  struct stat shm_stat;
+  if (!records || (records & (records - 1)) ||
+      size != sizeof(Header) + records * sizeof(ui::WaylandInputEvent) ||
+      fstat(handle.fd, &shm_stat) ||
+      static_cast<uint64_t>(shm_stat.st_size) < size) {
+    LOG(ERROR) << "Invalid input ring size " << size;
+    return false;
+  }
+
+  if (!shared_memory_->Map(size)) {
+    LOG(ERROR) << "Failed to map the input ring.";
+    return false;
+  }
+
+  size_ = size;
+  capacity_ = records;
+  return true;
+}
+
+base::SharedMemoryHandle WaylandInputRingBuffer::ShareHandle() const {
+  return base::FileDescriptor(dup(shared_memory_->handle().fd), true);
+}
+
+base::FileDescriptor WaylandInputRingBuffer::ShareDoorbell() const {
+  return base::FileDescriptor(dup(doorbell_fd_), true);
+}
+
+bool WaylandInputRingBuffer::Write(
+    const std::vector<ui::WaylandInputEvent>& events) {
+  DCHECK(capacity_);
+  Header* ring = header();
+  uint32_t write =
+      static_cast<uint32_t>(base::subtle::NoBarrier_Load(&ring->write_index));
+  uint32_t read =
+      static_cast<uint32_t>(base::subtle::Acquire_Load(&ring->read_index));
+  if (events.size() > capacity_ - (write - read))
+    return false;
+
+  ui::WaylandInputEvent* slots = records();
+  for (const ui::WaylandInputEvent& event : events)
+    slots[write++ & (capacity_ - 1)] = event;
+
+  base::subtle::Release_Store(&ring->write_index,
+                              static_cast<base::subtle::Atomic32>(write));
+  uint64_t value = 1;
+  if (HANDLE_EINTR(::write(doorbell_fd_, &value, sizeof(value))) < 0)
+    PLOG(ERROR) << "Failed to ring the input ring doorbell";
+
+  return true;
+}
+
+void WaylandInputRingBuffer::Read(uint32_t sequence,
+                                  std::vector<ui::WaylandInputEvent>* events) {
+  if (!capacity_)
+    return;
+
+  Header* ring = header();
+  uint32_t read =
+      static_cast<uint32_t>(base::subtle::NoBarrier_Load(&ring->read_index));
+  uint32_t write =
+      static_cast<uint32_t>(base::subtle::Acquire_Load(&ring->write_index));
+  if (write - read > capacity_) {
+    LOG(ERROR) << "Input ring is corrupted, dropping its content.";
+    base::subtle::Release_Store(&ring->read_index,
+                                static_cast<base::subtle::Atomic32>(write));
+    return;
+  }
+
+  const ui::WaylandInputEvent* slots = records();
+  for (; read != write; ++read) {
+    ui::WaylandInputEvent event = slots[read & (capacity_ - 1)];
+    // Sequences wrap around like the indices.
+    if (static_cast<int32_t>(event.sequence - sequence) > 0)
+      break;
+
+    if (IsValidEvent(event))
+      events->push_back(event);
+  }
+
+  base::subtle::Release_Store(&ring->read_index,
+                              static_cast<base::subtle::Atomic32>(read));
+}
+
+WaylandInputRingBuffer::Header* WaylandInputRingBuffer::header() const {
+  return static_cast<Header*>(shared_memory_->memory());
+}
+
+ui::WaylandInputEvent* WaylandInputRingBuffer::records() const {
+  return reinterpret_cast<ui::WaylandInputEvent*>(
+      static_cast<char*>(shared_memory_->memory()) + sizeof(Header));
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,70 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_INPUT_RING_BUFFER_H_
+#define OZONE_WAYLAND_INPUT_RING_BUFFER_H_
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/file_descriptor_posix.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "ozone/platform/wayland_input_event.h"
+
+namespace ozonewayland {
+
+// A single producer, single consumer ring of ui::WaylandInputEvent records in
+// shared memory. The GPU process writes batches of events from the Wayland
+// poll thread and rings an eventfd doorbell, the browser process reads them
+// without going through the GPU IPC channel. Only the two indices in the
+// header are shared state, records are plain old data. Records carry the
+// number of IPC messages sent before them in their |sequence|, so that the
+// consumer can keep them in order with those messages.
+class WaylandInputRingBuffer {
+ public:
+  WaylandInputRingBuffer();
+  ~WaylandInputRingBuffer();
+
+  // Producer side. Allocates room for at least |capacity| events and creates
+  // the doorbell.
+  bool Create(size_t capacity);
+  // Consumer side. Maps a ring of |size| bytes created by another process.
+  // Takes ownership of |handle| and |doorbell|.
+  bool Map(base::SharedMemoryHandle handle,
+           size_t size,
+           base::FileDescriptor doorbell);
+
+  // Return duplicates of the shared memory and the doorbell which can be sent
+  // to the consumer. Ownership is passed to the caller.
+  base::SharedMemoryHandle ShareHandle() const;
+  base::FileDescriptor ShareDoorbell() const;
+  size_t size() const { return size_; }
+
+  // Appends |events| to the ring and rings the doorbell. Returns false and
+  // writes nothing if there is not enough room for all of them.
+  bool Write(const std::vector<ui::WaylandInputEvent>& events);
+  // Appends the events written since the last call to |events|, up to the
+  // first one with a sequence newer than |sequence|, which is left in the
+  // ring. Records which don't describe a valid event are dropped, the
+  // producer is not trusted.
+  void Read(uint32_t sequence, std::vector<ui::WaylandInputEvent>* events);
+
+ private:
+  struct Header;
+  Header* header() const;
+  ui::WaylandInputEvent* records() const;
+
+  scoped_ptr<base::SharedMemory> shared_memory_;
+  size_t size_;
+  // Number of records, always a power of two.
+  uint32_t capacity_;
+  int doorbell_fd_;
+
+  DISALLOW_COPY_AND_ASSIGN(WaylandInputRingBuffer);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_INPUT_RING_BUFFER_H_
@@ -0,0 +1,168 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/overlay_planes.h"
+
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/protocol/viewporter-client-protocol.h"
+#include "ui/ozone/public/native_pixmap.h"
+
+namespace ozonewayland {
+
+WaylandOverlayPlanes::PlaneBuffer::PlaneBuffer() {
+}
+
+WaylandOverlayPlanes::PlaneBuffer::~PlaneBuffer() {
+}
+
+WaylandOverlayPlanes::PendingPlane::PendingPlane()
+    : buffer(NULL) {
+}
+
+WaylandOverlayPlanes::PendingPlane::~PendingPlane() {
+}
+
+WaylandOverlayPlanes::WaylandOverlayPlanes(wl_surface* parent)
+    : parent_(parent) {
+}
+
+WaylandOverlayPlanes::~WaylandOverlayPlanes() {
+  for (PlaneMap::iterator it = planes_.begin(); it != planes_.end(); ++it)
+    DestroyPlane(it->second);
+}
+
+bool WaylandOverlayPlanes::SchedulePlane(ui::NativePixmap* pixmap,
+                                         const BusyCallback& is_busy,
+                                         wl_buffer* buffer,
+                                         const gfx::Size& buffer_size,
+                                         int z_order,
+                                         const gfx::Rect& bounds,
+                                         const gfx::RectF& crop) {
+  if (z_order <= 0 || bounds.IsEmpty() ||
+      !WaylandDisplay::GetInstance()->GetSubcompositor()) {
+    return false;
+  }
+
+  // Without a viewport the buffer is shown as is.
+  if (!WaylandDisplay::GetInstance()->GetViewporter() &&
+      (bounds.size() != buffer_size || crop != gfx::RectF(1, 1))) {
+    return false;
+  }
+
+  PendingPlane& pending = pending_planes_[z_order];
+  pending.attach.pixmap = pixmap;
+  pending.attach.is_busy = is_busy;
+  pending.buffer = buffer;
+  pending.buffer_size = buffer_size;
+  pending.bounds = bounds;
+  pending.crop = crop;
+  return true;
+}
+
+void WaylandOverlayPlanes::CommitPlanes() {
+  DropReleasedBuffers();
+  if (planes_.empty() && pending_planes_.empty())
+    return;
+
+  // Hide the planes which weren't scheduled for this frame.
+  for (PlaneMap::iterator it = planes_.begin(); it != planes_.end(); ++it) {
+    Plane* plane = it->second;
+    if (pending_planes_.count(it->first) || !plane->attached.pixmap.get())
+      continue;
+
+    wl_surface_attach(plane->surface, NULL, 0, 0);
+    wl_surface_commit(plane->surface);
+    RetireBuffer(plane);
+  }
+
+  wl_surface* below = parent_;
+  for (PendingPlaneMap::iterator it = pending_planes_.begin();
+       it != pending_planes_.end(); ++it) {
+    const PendingPlane& pending = it->second;
+    Plane*& plane = planes_[it->first];
+    if (!plane)
+      plane = CreatePlane();
+
+    wl_subsurface_set_position(plane->subsurface,
+                               pending.bounds.x(),
+                               pending.bounds.y());
+    wl_subsurface_place_above(plane->subsurface, below);
+    below = plane->surface;
+    if (plane->viewport) {
+      const gfx::RectF& crop = pending.crop;
+      const gfx::Size& size = pending.buffer_size;
+      wp_viewport_set_source(
+          plane->viewport,
+          wl_fixed_from_double(crop.x() * size.width()),
+          wl_fixed_from_double(crop.y() * size.height()),
+          wl_fixed_from_double(crop.width() * size.width()),
+          wl_fixed_from_double(crop.height() * size.height()));
+      wp_viewport_set_destination(plane->viewport,
+                                  pending.bounds.width(),
+                                  pending.bounds.height());
+    }
+
+    wl_surface_attach(plane->surface, pending.buffer, 0, 0);
+    wl_surface_damage(plane->surface, 0, 0,
+                      pending.buffer_size.width(),
+                      pending.buffer_size.height());
+    wl_surface_commit(plane->surface);
+    if (plane->attached.pixmap.get() != pending.attach.pixmap.get())
+      RetireBuffer(plane);
+    plane->attached = pending.attach;
+  }
+
+  TRACE_COUNTER_ID1("ozone", "WaylandOverlayPlanes", this,
+                    pending_planes_.size());
+  pending_planes_.clear();
+}
+
+WaylandOverlayPlanes::Plane* WaylandOverlayPlanes::CreatePlane() {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  Plane* plane = new Plane;
+  plane->surface = wl_compositor_create_surface(display->GetCompositor());
+  plane->subsurface = wl_subcompositor_get_subsurface(
+      display->GetSubcompositor(), plane->surface, parent_);
+  plane->viewport = NULL;
+  if (display->GetViewporter()) {
+    plane->viewport = wp_viewporter_get_viewport(display->GetViewporter(),
+                                                 plane->surface);
+  }
+
+  // Input goes to the window, whatever is shown on top of it.
+  wl_region* region =
+      wl_compositor_create_region(display->GetCompositor());
+  wl_surface_set_input_region(plane->surface, region);
+  wl_region_destroy(region);
+  return plane;
+}
+
+void WaylandOverlayPlanes::DestroyPlane(Plane* plane) {
+  if (plane->viewport)
+    wp_viewport_destroy(plane->viewport);
+
+  wl_subsurface_destroy(plane->subsurface);
+  wl_surface_destroy(plane->surface);
+  delete plane;
+}
+
+void WaylandOverlayPlanes::RetireBuffer(Plane* plane) {
+  if (plane->attached.pixmap.get())
+    retired_buffers_.push_back(plane->attached);
+  plane->attached = PlaneBuffer();
+}
+
+void WaylandOverlayPlanes::DropReleasedBuffers() {
+  std::vector<PlaneBuffer>::iterator it = retired_buffers_.begin();
+  while (it != retired_buffers_.end()) {
+    if (it->is_busy.Run())
+      ++it;
+    else
+      it = retired_buffers_.erase(it);
+  }
+}
+
+}  // namespace ozonewayland
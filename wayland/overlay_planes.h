@@ -0,0 +1,106 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_OVERLAY_PLANES_H_
+#define OZONE_WAYLAND_OVERLAY_PLANES_H_
+
+#include <wayland-client.h>
+
+#include <map>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/rect_f.h"
+
+struct wp_viewport;
+
+namespace ui {
+class NativePixmap;
+}
+
+namespace ozonewayland {
+
+// Shows overlay planes of a window as subsurfaces stacked above the surface
+// of the window, one per z-order. Planes are scheduled for every frame and
+// committed together with the frame, planes which aren't scheduled again are
+// hidden. Subsurfaces are synchronized, so the compositor shows a new set of
+// planes along with the frame they belong to.
+class WaylandOverlayPlanes {
+ public:
+  // Returns true while the compositor may still read from a buffer.
+  typedef base::Callback<bool(void)> BusyCallback;
+
+  explicit WaylandOverlayPlanes(wl_surface* parent);
+  ~WaylandOverlayPlanes();
+
+  // Schedules |buffer| of |pixmap| to be shown at |bounds| in surface
+  // coordinates on plane |z_order|, which must be above the window. |crop| is
+  // the part of the buffer to show, normalized to its |buffer_size|. |pixmap|
+  // is kept until |is_busy| returns false after the plane shows another
+  // buffer. Returns false if the compositor can't show the plane.
+  bool SchedulePlane(ui::NativePixmap* pixmap,
+                     const BusyCallback& is_busy,
+                     wl_buffer* buffer,
+                     const gfx::Size& buffer_size,
+                     int z_order,
+                     const gfx::Rect& bounds,
+                     const gfx::RectF& crop);
+  // Commits the planes scheduled since the last call. They become visible
+  // with the next commit of the parent surface.
+  void CommitPlanes();
+
+ private:
+  // Keeps the buffer attached to a plane alive.
+  struct PlaneBuffer {
+    PlaneBuffer();
+    ~PlaneBuffer();
+
+    scoped_refptr<ui::NativePixmap> pixmap;
+    BusyCallback is_busy;
+  };
+
+  struct Plane {
+    wl_surface* surface;
+    wl_subsurface* subsurface;
+    wp_viewport* viewport;
+    PlaneBuffer attached;
+  };
+
+  struct PendingPlane {
+    PendingPlane();
+    ~PendingPlane();
+
+    PlaneBuffer attach;
+    wl_buffer* buffer;
+    gfx::Size buffer_size;
+    gfx::Rect bounds;
+    gfx::RectF crop;
+  };
+
+  typedef std::map<int, Plane*> PlaneMap;
+  typedef std::map<int, PendingPlane> PendingPlaneMap;
+
+  Plane* CreatePlane();
+  void DestroyPlane(Plane* plane);
+  // Keeps the buffer attached to |plane| until the compositor releases it.
+  void RetireBuffer(Plane* plane);
+  // Drops the retired buffers the compositor has released.
+  void DropReleasedBuffers();
+
+  wl_surface* parent_;
+  // Ordered by z-order, so stacking them in order is bottom to top.
+  PlaneMap planes_;
+  PendingPlaneMap pending_planes_;
+  // Buffers replaced on their plane, which the compositor may still show
+  // until the parent surface is committed and the new ones are shown.
+  std::vector<PlaneBuffer> retired_buffers_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandOverlayPlanes);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_OVERLAY_PLANES_H_
@@ -65,7 +65,7 @@ void OzoneWaylandScreen::DisplayHandleOutputOnly(void *data,
   OzoneWaylandScreen* disp = static_cast<OzoneWaylandScreen*>(data);
 
   if (strcmp(interface, "wl_output") == 0) {
-    WaylandScreen* screen = new WaylandScreen(registry, name);
+    WaylandScreen* screen = new WaylandScreen(registry, name, version);
     disp->look_ahead_screen_ = screen;
   }
 }
@@ -6,22 +6,30 @@
 #include "ozone/wayland/screen.h"
 
 #include <wayland-client.h>
+#include <algorithm>
 
 #include "ozone/wayland/display.h"
 
 namespace ozonewayland {
 
-WaylandScreen::WaylandScreen(wl_registry* registry, uint32_t id)
+WaylandScreen::WaylandScreen(wl_registry* registry,
+                             uint32_t id,
+                             uint32_t version)
     : output_(NULL),
       refresh_(0),
+      scale_(1),
       rect_(0, 0, 0, 0) {
   static const wl_output_listener kOutputListener = {
     WaylandScreen::OutputHandleGeometry,
     WaylandScreen::OutputHandleMode,
+    WaylandScreen::OutputHandleDone,
+    WaylandScreen::OutputHandleScale,
   };
 
+  // Version 2 adds the scale of the output.
   output_ = static_cast<wl_output*>(
-      wl_registry_bind(registry, id, &wl_output_interface, 1));
+      wl_registry_bind(registry, id, &wl_output_interface,
+                       std::min(version, 2u)));
   wl_output_add_listener(output_, &kOutputListener, this);
   DCHECK(output_);
 }
@@ -30,6 +38,14 @@ WaylandScreen::~WaylandScreen() {
   wl_output_destroy(output_);
 }
 
+int32_t WaylandScreen::RefreshRate() const {
+  return base::subtle::NoBarrier_Load(&refresh_);
+}
+
+int32_t WaylandScreen::Scale() const {
+  return base::subtle::NoBarrier_Load(&scale_);
+}
+
 // static
 void WaylandScreen::OutputHandleGeometry(void *data,
                                          wl_output *output,
@@ -56,7 +72,7 @@ void WaylandScreen::OutputHandleMode(void* data,
   if (flags & WL_OUTPUT_MODE_CURRENT) {
     screen->rect_.set_width(width);
     screen->rect_.set_height(height);
-    screen->refresh_ = refresh;
+    base::subtle::NoBarrier_Store(&screen->refresh_, refresh);
 
     if (!WaylandDisplay::GetInstance())
       return;
@@ -65,4 +81,16 @@ void WaylandScreen::OutputHandleMode(void* data,
   }
 }
 
+// static
+void WaylandScreen::OutputHandleDone(void* data, wl_output* wl_output) {
+}
+
+// static
+void WaylandScreen::OutputHandleScale(void* data,
+                                      wl_output* wl_output,
+                                      int32_t factor) {
+  WaylandScreen* screen = static_cast<WaylandScreen*>(data);
+  base::subtle::NoBarrier_Store(&screen->scale_, std::max(factor, 1));
+}
+
 }  // namespace ozonewayland
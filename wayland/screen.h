@@ -8,6 +8,7 @@
 
 #include <stdint.h>
 
+#include "base/atomicops.h"
 #include "base/basictypes.h"
 #include "ui/gfx/geometry/rect.h"
 
@@ -22,11 +23,18 @@ class WaylandDisplay;
 // that are available to the application.
 class WaylandScreen {
  public:
-  WaylandScreen(wl_registry* registry, uint32_t id);
+  WaylandScreen(wl_registry* registry, uint32_t id, uint32_t version);
   ~WaylandScreen();
 
   // Returns the active allocation of the screen.
   gfx::Rect Geometry() const { return rect_; }
+  // Refresh rate of the active mode in mHz, 0 if unknown. Can be called from
+  // any thread.
+  int32_t RefreshRate() const;
+  // Scale factor of the output, 1 unless the compositor says otherwise. Can
+  // be called from any thread.
+  int32_t Scale() const;
+  wl_output* output() const { return output_; }
 
  private:
   // Callback functions that allows the display to initialize the screen's
@@ -49,11 +57,20 @@ class WaylandScreen {
                                int32_t height,
                                int32_t refresh);
 
+  static void OutputHandleDone(void* data, wl_output* wl_output);
+
+  static void OutputHandleScale(void* data,
+                                wl_output* wl_output,
+                                int32_t factor);
+
   // The Wayland output this object wraps
   wl_output* output_;
 
-  // Rect and Refresh rate of active mode.
-  int32_t refresh_;
+  // Rect and Refresh rate of active mode. |refresh_| is read by the GPU
+  // thread to derive the vsync interval.
+  base::subtle::Atomic32 refresh_;
+  // Read by the GPU main thread to pick the size of themed cursors.
+  base::subtle::Atomic32 scale_;
   gfx::Rect rect_;
 
   DISALLOW_COPY_AND_ASSIGN(WaylandScreen);
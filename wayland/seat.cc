@@ -5,19 +5,45 @@
 
 #include "ozone/wayland/seat.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "ozone/wayland/data_device.h"
 #include "ozone/wayland/display.h"
 #include "ozone/wayland/input/cursor.h"
+#include "ozone/wayland/input/cursor_theme.h"
 #include "ozone/wayland/input/keyboard.h"
 #include "ozone/wayland/input/pointer.h"
 #include "ozone/wayland/input/text_input.h"
 #include "ozone/wayland/input/touchscreen.h"
+#include "ozone/wayland/screen.h"
+#include "ozone/wayland/shell/shell_surface.h"
+#include "ozone/wayland/window.h"
 
 namespace ozonewayland {
 
+namespace {
+
+// Version 5 adds the frame, axis_source, axis_stop and axis_discrete events of
+// wl_pointer, which headers older than Wayland 1.10 don't have.
+#if defined(WL_POINTER_FRAME_SINCE_VERSION)
+const uint32_t kMaxSeatVersion = 5;
+#else
+const uint32_t kMaxSeatVersion = 1;
+#endif
+
+}  // namespace
+
+WaylandSeat::RegisteredCursor::RegisteredCursor()
+    : frame_delay_ms(0) {
+}
+
+WaylandSeat::RegisteredCursor::~RegisteredCursor() {
+}
+
 WaylandSeat::WaylandSeat(WaylandDisplay* display,
-                         uint32_t id)
+                         uint32_t id,
+                         uint32_t version)
     : focused_window_handle_(0),
       grab_window_handle_(0),
       grab_button_(0),
@@ -28,11 +54,21 @@ WaylandSeat::WaylandSeat(WaylandDisplay* display,
       text_input_(NULL) {
   static const struct wl_seat_listener kInputSeatListener = {
     WaylandSeat::OnSeatCapabilities,
+#if defined(WL_SEAT_NAME_SINCE_VERSION)
+    WaylandSeat::OnSeatName,
+#endif
   };
 
   seat_ = static_cast<wl_seat*>(
-      wl_registry_bind(display->registry(), id, &wl_seat_interface, 1));
+      wl_registry_bind(display->registry(), id, &wl_seat_interface,
+                       std::min(version, kMaxSeatVersion)));
   DCHECK(seat_);
+  // Pointer, keyboard and touch objects are created from the seat and inherit
+  // its queue, so all input is dispatched from the input queue. The data
+  // device and text input are created by their managers and stay on the
+  // default queue.
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(seat_),
+                     display->input_queue());
   wl_seat_add_listener(seat_, &kInputSeatListener, this);
   wl_seat_set_user_data(seat_, this);
 
@@ -78,6 +114,11 @@ void WaylandSeat::OnSeatCapabilities(void *data, wl_seat *seat, uint32_t caps) {
   }
 }
 
+#if defined(WL_SEAT_NAME_SINCE_VERSION)
+void WaylandSeat::OnSeatName(void* data, wl_seat* seat, const char* name) {
+}
+#endif
+
 void WaylandSeat::SetFocusWindowHandle(unsigned windowhandle) {
   focused_window_handle_ = windowhandle;
   WaylandWindow* window = NULL;
@@ -92,13 +133,93 @@ void WaylandSeat::SetGrabWindowHandle(unsigned windowhandle, uint32_t button) {
 }
 
 void WaylandSeat::SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                                  const gfx::Point& location) {
+                                  const gfx::Point& location,
+                                  int frame_delay_ms) {
   if (!input_pointer_) {
     LOG(WARNING) << "Tried to change cursor without input configured";
     return;
   }
   input_pointer_->Cursor()->UpdateBitmap(
-      bitmaps, location, WaylandDisplay::GetInstance()->GetSerial());
+      bitmaps, location, frame_delay_ms,
+      WaylandDisplay::GetInstance()->GetSerial());
+}
+
+void WaylandSeat::RegisterCursor(uint32_t id,
+                                 const std::vector<SkBitmap>& bitmaps,
+                                 const gfx::Point& hotspot,
+                                 int frame_delay_ms) {
+  RegisteredCursor& cursor = cursors_[id];
+  cursor.bitmaps = bitmaps;
+  cursor.hotspot = hotspot;
+  cursor.frame_delay_ms = frame_delay_ms;
+}
+
+void WaylandSeat::SetCursor(uint32_t id) {
+  if (!id) {
+    SetCursorBitmap(std::vector<SkBitmap>(), gfx::Point(), 0);
+    return;
+  }
+
+  std::map<uint32_t, RegisteredCursor>::const_iterator it = cursors_.find(id);
+  if (it == cursors_.end()) {
+    LOG(WARNING) << "Tried to set unregistered cursor " << id;
+    return;
+  }
+
+  SetCursorBitmap(it->second.bitmaps,
+                  it->second.hotspot,
+                  it->second.frame_delay_ms);
+}
+
+void WaylandSeat::EvictCursor(uint32_t id) {
+  cursors_.erase(id);
+}
+
+void WaylandSeat::SetCursorType(ui::WaylandCursorType type) {
+  if (!input_pointer_) {
+    LOG(WARNING) << "Tried to change cursor without input configured";
+    return;
+  }
+
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandCursorTheme* theme = display->GetCursorTheme();
+  if (type == ui::CURSOR_NONE || !theme) {
+    SetCursorBitmap(std::vector<SkBitmap>(), gfx::Point(), 0);
+    return;
+  }
+
+  int scale = GetCursorScale();
+  wl_cursor* cursor = theme->GetCursor(type, scale);
+  if (!cursor && scale != 1) {
+    scale = 1;
+    cursor = theme->GetCursor(type, scale);
+  }
+
+  if (!cursor) {
+    LOG(WARNING) << "Cursor theme has no cursor of type " << type;
+    return;
+  }
+
+  input_pointer_->Cursor()->UpdateThemeCursor(cursor,
+                                              scale,
+                                              display->GetSerial());
+}
+
+int WaylandSeat::GetCursorScale() const {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  // Cursor surfaces can only be scaled from version 3 of wl_compositor.
+  if (display->GetCompositorVersion() < 3)
+    return 1;
+
+  WaylandScreen* screen = NULL;
+  WaylandWindow* window = focused_window_handle_ ?
+      display->GetWindow(focused_window_handle_) : NULL;
+  if (window && window->ShellSurface())
+    screen = window->ShellSurface()->CurrentScreen();
+  if (!screen)
+    screen = display->PrimaryScreen();
+
+  return screen ? screen->Scale() : 1;
 }
 
 void WaylandSeat::MoveCursor(const gfx::Point& location) {
@@ -6,9 +6,11 @@
 #define OZONE_WAYLAND_SEAT_H_
 
 #include <wayland-client.h>
+#include <map>
 #include <vector>
 
 #include "base/basictypes.h"
+#include "ozone/platform/window_constants.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "ui/gfx/geometry/rect.h"
 
@@ -23,7 +25,7 @@ class WaylandTextInput;
 
 class WaylandSeat {
  public:
-  WaylandSeat(WaylandDisplay* display, uint32_t id);
+  WaylandSeat(WaylandDisplay* display, uint32_t id, uint32_t version);
   ~WaylandSeat();
 
   wl_seat* GetWLSeat() const { return seat_; }
@@ -36,18 +38,45 @@ class WaylandSeat {
   void SetFocusWindowHandle(unsigned windowhandle);
   void SetGrabWindowHandle(unsigned windowhandle, uint32_t button);
   void SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                       const gfx::Point& location);
+                       const gfx::Point& location,
+                       int frame_delay_ms);
   void MoveCursor(const gfx::Point& location);
 
+  // Cursors registered by the browser, which afterwards only sends their id.
+  void RegisterCursor(uint32_t id,
+                      const std::vector<SkBitmap>& bitmaps,
+                      const gfx::Point& hotspot,
+                      int frame_delay_ms);
+  // Shows the cursor registered with |id|, hides the cursor if |id| is 0.
+  void SetCursor(uint32_t id);
+  void EvictCursor(uint32_t id);
+  // Shows a standard cursor from the cursor theme, at the scale of the output
+  // the focused window is on.
+  void SetCursorType(ui::WaylandCursorType type);
+
   void ResetIme();
   void ImeCaretBoundsChanged(gfx::Rect rect);
   void ShowInputPanel();
   void HideInputPanel();
 
  private:
+  struct RegisteredCursor {
+    RegisteredCursor();
+    ~RegisteredCursor();
+
+    std::vector<SkBitmap> bitmaps;
+    gfx::Point hotspot;
+    int frame_delay_ms;
+  };
+
+  int GetCursorScale() const;
+
   static void OnSeatCapabilities(void *data,
                                  wl_seat *seat,
                                  uint32_t caps);
+#if defined(WL_SEAT_NAME_SINCE_VERSION)
+  static void OnSeatName(void* data, wl_seat* seat, const char* name);
+#endif
 
   // Keeps track of current focused window.
   unsigned focused_window_handle_;
@@ -59,6 +88,7 @@ class WaylandSeat {
   WaylandPointer* input_pointer_;
   WaylandTouchscreen* input_touch_;
   WaylandTextInput* text_input_;
+  std::map<uint32_t, RegisteredCursor> cursors_;
 
   DISALLOW_COPY_AND_ASSIGN(WaylandSeat);
 };
@@ -43,9 +43,15 @@ WaylandShell::CreateShellSurface(WaylandWindow* window,
   if (!surface)
     surface = new WLShellSurface();
 
+  static const struct wl_surface_listener kSurfaceListener = {
+    WaylandShellSurface::SurfaceEnter,
+    WaylandShellSurface::SurfaceLeave,
+  };
+
   DCHECK(surface);
   surface->InitializeShellSurface(window, type);
-  wl_surface_set_user_data(surface->GetWLSurface(), window);
+  // Also sets |window| as user data of the surface.
+  wl_surface_add_listener(surface->GetWLSurface(), &kSurfaceListener, window);
   display->FlushDisplay();
 
   return surface;
@@ -5,12 +5,14 @@
 #include "ozone/wayland/shell/shell_surface.h"
 
 #include "ozone/wayland/display.h"
+#include "ozone/wayland/screen.h"
 #include "ozone/wayland/seat.h"
 
 namespace ozonewayland {
 
 WaylandShellSurface::WaylandShellSurface()
-    : surface_(NULL) {
+    : surface_(NULL),
+      current_screen_(0) {
   WaylandDisplay* display = WaylandDisplay::GetInstance();
   surface_ = wl_compositor_create_surface(display->GetCompositor());
 }
@@ -25,6 +27,11 @@ struct wl_surface* WaylandShellSurface::GetWLSurface() const {
     return surface_;
 }
 
+WaylandScreen* WaylandShellSurface::CurrentScreen() const {
+  return reinterpret_cast<WaylandScreen*>(
+      base::subtle::Acquire_Load(&current_screen_));
+}
+
 void WaylandShellSurface::FlushDisplay() const {
   WaylandDisplay* display = WaylandDisplay::GetInstance();
   DCHECK(display);
@@ -67,4 +74,31 @@ void WaylandShellSurface::WindowDeActivated(void *data) {
   WaylandDisplay::GetInstance()->WindowDeActivated(window->Handle());
 }
 
+void WaylandShellSurface::SurfaceEnter(void* data,
+                                       struct wl_surface* surface,
+                                       struct wl_output* output) {
+  WaylandWindow* window = static_cast<WaylandWindow*>(data);
+  WaylandShellSurface* shell_surface = window->ShellSurface();
+  if (!shell_surface)
+    return;
+
+  WaylandScreen* screen = WaylandDisplay::GetInstance()->GetScreen(output);
+  base::subtle::Release_Store(&shell_surface->current_screen_,
+                              reinterpret_cast<base::subtle::AtomicWord>(
+                                  screen));
+}
+
+void WaylandShellSurface::SurfaceLeave(void* data,
+                                       struct wl_surface* surface,
+                                       struct wl_output* output) {
+  WaylandWindow* window = static_cast<WaylandWindow*>(data);
+  WaylandShellSurface* shell_surface = window->ShellSurface();
+  if (!shell_surface)
+    return;
+
+  WaylandScreen* screen = shell_surface->CurrentScreen();
+  if (screen && screen->output() == output)
+    base::subtle::Release_Store(&shell_surface->current_screen_, 0);
+}
+
 }  // namespace ozonewayland
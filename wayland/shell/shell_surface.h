@@ -7,11 +7,13 @@
 
 #include <wayland-client.h>
 
+#include "base/atomicops.h"
 #include "base/basictypes.h"
 #include "ozone/wayland/window.h"
 
 namespace ozonewayland {
 
+class WaylandScreen;
 class WaylandWindow;
 
 class WaylandShellSurface {
@@ -20,6 +22,9 @@ class WaylandShellSurface {
   virtual ~WaylandShellSurface();
 
   struct wl_surface* GetWLSurface() const;
+  // Screen the surface was last shown on, NULL if unknown. Can be called from
+  // any thread.
+  WaylandScreen* CurrentScreen() const;
 
   // The implementation should initialize the shell and set up all
   // necessary callbacks.
@@ -40,12 +45,21 @@ class WaylandShellSurface {
   static void WindowResized(void *data, unsigned width, unsigned height);
   static void WindowActivated(void *data);
   static void WindowDeActivated(void *data);
+  // wl_surface listener, |data| is the WaylandWindow.
+  static void SurfaceEnter(void* data,
+                           struct wl_surface* surface,
+                           struct wl_output* output);
+  static void SurfaceLeave(void* data,
+                           struct wl_surface* surface,
+                           struct wl_output* output);
 
  protected:
   void FlushDisplay() const;
 
  private:
   struct wl_surface* surface_;
+  // WaylandScreen*, written on the thread dispatching Wayland events.
+  base::subtle::AtomicWord current_screen_;
   DISALLOW_COPY_AND_ASSIGN(WaylandShellSurface);
 };
 
@@ -0,0 +1,103 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/shm_surface.h"
+
+#include <sys/stat.h>
+
+#include "base/logging.h"
+#include "base/numerics/safe_math.h"
+#include "base/stl_util.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/wayland/display.h"
+
+namespace ozonewayland {
+
+WaylandShmSurface::WaylandShmSurface(unsigned handle, wl_surface* surface)
+    : handle_(handle),
+      surface_(surface),
+      first_id_(0) {
+}
+
+WaylandShmSurface::~WaylandShmSurface() {
+  DestroyBuffers();
+}
+
+bool WaylandShmSurface::SetBuffers(base::ScopedFD fd,
+                                   const gfx::Size& size,
+                                   uint32_t count,
+                                   uint32_t first_id) {
+  static const struct wl_buffer_listener kBufferListener = {
+    WaylandShmSurface::BufferRelease
+  };
+
+  DestroyBuffers();
+  wl_shm* shm = WaylandDisplay::GetInstance()->GetShm();
+  // The protocol takes sizes and offsets as int32.
+  base::CheckedNumeric<int32_t> stride = size.width();
+  stride *= 4;
+  base::CheckedNumeric<int32_t> buffer_size = stride * size.height();
+  base::CheckedNumeric<int32_t> pool_size = buffer_size * count;
+  struct stat shm_stat;
+  if (!shm || !fd.is_valid() || size.IsEmpty() || !count ||
+      !pool_size.IsValid() || fstat(fd.get(), &shm_stat) ||
+      shm_stat.st_size < pool_size.ValueOrDie()) {
+    LOG(ERROR) << "Invalid canvas buffers for window " << handle_;
+    return false;
+  }
+
+  first_id_ = first_id;
+  // The pool stays alive as long as buffers created from it do.
+  wl_shm_pool* pool =
+      wl_shm_create_pool(shm, fd.get(), pool_size.ValueOrDie());
+  for (uint32_t i = 0; i < count; ++i) {
+    Buffer* buffer = new Buffer;
+    buffer->surface = this;
+    buffer->id = first_id + i;
+    buffer->buffer = wl_shm_pool_create_buffer(pool,
+                                               i * buffer_size.ValueOrDie(),
+                                               size.width(),
+                                               size.height(),
+                                               stride.ValueOrDie(),
+                                               WL_SHM_FORMAT_ARGB8888);
+    wl_buffer_add_listener(buffer->buffer, &kBufferListener, buffer);
+    buffers_.push_back(buffer);
+  }
+
+  wl_shm_pool_destroy(pool);
+  return true;
+}
+
+void WaylandShmSurface::Present(uint32_t id, const gfx::Rect& damage) {
+  TRACE_EVENT1("ozone", "WaylandShmSurface::Present", "id", id);
+  uint32_t index = id - first_id_;
+  if (index >= buffers_.size()) {
+    LOG(ERROR) << "Invalid canvas buffer " << id << " for window " << handle_;
+    return;
+  }
+
+  wl_surface_attach(surface_, buffers_[index]->buffer, 0, 0);
+  wl_surface_damage(surface_,
+                    damage.x(),
+                    damage.y(),
+                    damage.width(),
+                    damage.height());
+  wl_surface_commit(surface_);
+}
+
+// static
+void WaylandShmSurface::BufferRelease(void* data, wl_buffer* buffer) {
+  Buffer* shm_buffer = static_cast<Buffer*>(data);
+  WaylandDisplay::GetInstance()->CanvasBufferReleased(
+      shm_buffer->surface->handle_, shm_buffer->id);
+}
+
+void WaylandShmSurface::DestroyBuffers() {
+  for (Buffer* buffer : buffers_)
+    wl_buffer_destroy(buffer->buffer);
+
+  STLDeleteElements(&buffers_);
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,55 @@
+// Copyright 2015 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_SHM_SURFACE_H_
+#define OZONE_WAYLAND_SHM_SURFACE_H_
+
+#include <wayland-client.h>
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/files/scoped_file.h"
+#include "ui/gfx/geometry/rect.h"
+
+namespace ozonewayland {
+
+// Presents the software rendered frames of a window. The browser draws into
+// buffers in shared memory, which are wrapped into wl_buffers here and
+// attached to the surface of the window. The browser is told when the
+// compositor releases a buffer, so that it can draw into it again.
+class WaylandShmSurface {
+ public:
+  WaylandShmSurface(unsigned handle, wl_surface* surface);
+  ~WaylandShmSurface();
+
+  // Replaces the buffers by |count| ARGB buffers of |size|, which are laid out
+  // one after the other in |fd| and numbered from |first_id| on.
+  bool SetBuffers(base::ScopedFD fd,
+                  const gfx::Size& size,
+                  uint32_t count,
+                  uint32_t first_id);
+  // Attaches buffer |id|, damages |damage| and commits the surface.
+  void Present(uint32_t id, const gfx::Rect& damage);
+
+ private:
+  struct Buffer {
+    WaylandShmSurface* surface;
+    wl_buffer* buffer;
+    uint32_t id;
+  };
+
+  static void BufferRelease(void* data, wl_buffer* buffer);
+  void DestroyBuffers();
+
+  unsigned handle_;
+  wl_surface* surface_;
+  std::vector<Buffer*> buffers_;
+  uint32_t first_id_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandShmSurface);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_SHM_SURFACE_H_
@@ -70,9 +70,16 @@
           'defines': [
           'ENABLE_DRM_SUPPORT',
           ],
+          'direct_dependent_settings': {
+            'defines': [
+              'ENABLE_DRM_SUPPORT',
+            ],
+          },
           'sources': [
             'egl/wayland_pixmap.cc',
             'egl/wayland_pixmap.h',
+            'egl/wayland_pixmap_pool.cc',
+            'egl/wayland_pixmap_pool.h',
             'protocol/wayland-drm-protocol.cc',
             'protocol/wayland-drm-protocol.h',
           ],
@@ -85,22 +92,38 @@
         'data_offer.h',
         'display.cc',
         'display.h',
+        'display_event_watcher.cc',
+        'display_event_watcher.h',
+        'display_message_filter.cc',
+        'display_message_filter.h',
         'display_poll_thread.cc',
         'display_poll_thread.h',
+        'input_ring_buffer.cc',
+        'input_ring_buffer.h',
+        'overlay_planes.cc',
+        'overlay_planes.h',
         'ozone_wayland_screen.cc',
         'ozone_wayland_screen.h',
         'screen.cc',
         'screen.h',
         'seat.cc',
         'seat.h',
+        'shm_surface.cc',
+        'shm_surface.h',
         'window.cc',
         'window.h',
         'egl/egl_window.cc',
         'egl/egl_window.h',
         'egl/surface_ozone_wayland.cc',
         'egl/surface_ozone_wayland.h',
+        'egl/wayland_frame_clock.cc',
+        'egl/wayland_frame_clock.h',
+        'egl/wayland_vsync_provider.cc',
+        'egl/wayland_vsync_provider.h',
         'input/cursor.cc',
         'input/cursor.h',
+        'input/cursor_theme.cc',
+        'input/cursor_theme.h',
         'input/keyboard.cc',
         'input/keyboard.h',
         'input/pointer.cc',
@@ -111,8 +134,14 @@
         'input/touchscreen.h',
         'protocol/text-protocol.c',
         'protocol/text-client-protocol.h',
+        'protocol/viewporter-protocol.c',
+        'protocol/viewporter-client-protocol.h',
         'protocol/ivi-application-protocol.c',
         'protocol/ivi-application-client-protocol.h',
+        'protocol/linux-dmabuf-protocol.c',
+        'protocol/linux-dmabuf-client-protocol.h',
+        'protocol/presentation-time-protocol.c',
+        'protocol/presentation-time-client-protocol.h',
         'protocol/xdg-shell-protocol.c',
         'protocol/xdg-shell-client-protocol.h',
         'shell/shell.cc',
@@ -8,14 +8,18 @@
 #include "base/logging.h"
 #include "ozone/wayland/display.h"
 #include "ozone/wayland/egl/egl_window.h"
+#include "ozone/wayland/overlay_planes.h"
 #include "ozone/wayland/seat.h"
 #include "ozone/wayland/shell/shell.h"
 #include "ozone/wayland/shell/shell_surface.h"
+#include "ozone/wayland/shm_surface.h"
 
 namespace ozonewayland {
 
 WaylandWindow::WaylandWindow(unsigned handle) : shell_surface_(NULL),
     window_(NULL),
+    shm_surface_(NULL),
+    overlay_planes_(NULL),
     type_(None),
     handle_(handle),
     allocation_(gfx::Rect(0, 0, 1, 1)) {
@@ -32,6 +36,8 @@ WaylandWindow::~WaylandWindow() {
   }
 
   delete window_;
+  delete overlay_planes_;
+  delete shm_surface_;
   delete shell_surface_;
 }
 
@@ -120,6 +126,34 @@ wl_egl_window* WaylandWindow::egl_window() const {
   return window_->egl_window();
 }
 
+WaylandShmSurface* WaylandWindow::ShmSurface() {
+  if (!shell_surface_) {
+    LOG(ERROR) << "Shell type not set. Setting it to TopLevel";
+    SetShellAttributes(TOPLEVEL);
+  }
+
+  if (!shm_surface_)
+    shm_surface_ = new WaylandShmSurface(handle_,
+                                         shell_surface_->GetWLSurface());
+  return shm_surface_;
+}
+
+WaylandOverlayPlanes* WaylandWindow::OverlayPlanes() {
+  if (!shell_surface_) {
+    LOG(ERROR) << "Shell type not set. Setting it to TopLevel";
+    SetShellAttributes(TOPLEVEL);
+  }
+
+  if (!overlay_planes_)
+    overlay_planes_ = new WaylandOverlayPlanes(shell_surface_->GetWLSurface());
+  return overlay_planes_;
+}
+
+void WaylandWindow::CommitOverlayPlanes() {
+  if (overlay_planes_)
+    overlay_planes_->CommitPlanes();
+}
+
 void WaylandWindow::Resize(unsigned width, unsigned height) {
   if ((allocation_.width() == width) && (allocation_.height() == height))
     return;
@@ -150,21 +184,33 @@ void WaylandWindow::Move(ShellType type, WaylandShellSurface* shell_parent,
   window_->Move(allocation_.width(), allocation_.height(), move_x, move_y);
 }
 
-void WaylandWindow::AddRegion(int left, int top, int right, int bottom) {
-  wl_compositor* com = WaylandDisplay::GetInstance()->GetCompositor();
-  struct wl_region *region = wl_compositor_create_region(com);
-  wl_region_add(region, left, top, right, bottom);
-  wl_surface_set_input_region(shell_surface_->GetWLSurface(), region);
-  wl_surface_set_opaque_region(shell_surface_->GetWLSurface(), region);
-  wl_region_destroy(region);
+void WaylandWindow::SetRegion(const std::vector<gfx::Rect>& opaque_region,
+                              const std::vector<gfx::Rect>& input_region) {
+  struct wl_surface* surface = shell_surface_->GetWLSurface();
+  struct wl_region* region = CreateRegion(opaque_region);
+  wl_surface_set_opaque_region(surface, region);
+  if (region)
+    wl_region_destroy(region);
+
+  region = CreateRegion(input_region);
+  wl_surface_set_input_region(surface, region);
+  if (region)
+    wl_region_destroy(region);
 }
 
-void WaylandWindow::SubRegion(int left, int top, int right, int bottom) {
+struct wl_region* WaylandWindow::CreateRegion(
+    const std::vector<gfx::Rect>& rects) {
+  if (rects.empty())
+    return NULL;
+
   wl_compositor* com = WaylandDisplay::GetInstance()->GetCompositor();
-  struct wl_region *region = wl_compositor_create_region(com);
-  wl_region_subtract(region, left, top, right, bottom);
-  wl_surface_set_opaque_region(shell_surface_->GetWLSurface(), region);
-  wl_region_destroy(region);
+  struct wl_region* region = wl_compositor_create_region(com);
+  for (size_t i = 0; i < rects.size(); ++i) {
+    const gfx::Rect& rect = rects[i];
+    wl_region_add(region, rect.x(), rect.y(), rect.width(), rect.height());
+  }
+
+  return region;
 }
 
 }  // namespace ozonewayland
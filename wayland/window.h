@@ -7,13 +7,16 @@
 #define OZONE_WAYLAND_WINDOW_H_
 
 #include <wayland-client.h>
+#include <vector>
 
 #include "base/strings/string16.h"
 #include "ui/gfx/geometry/rect.h"
 
 namespace ozonewayland {
 
+class WaylandOverlayPlanes;
 class WaylandShellSurface;
+class WaylandShmSurface;
 class EGLWindow;
 struct wl_egl_window;
 
@@ -54,18 +57,36 @@ class WaylandWindow {
   // The WaylandWindow object owns the pointer.
   wl_egl_window* egl_window() const;
 
+  // Returns the surface presenting software rendered frames of the window,
+  // creating it if needed. The WaylandWindow object owns the pointer.
+  WaylandShmSurface* ShmSurface();
+  // Returns the overlay planes shown above the window, creating them if
+  // needed. The WaylandWindow object owns the pointer.
+  WaylandOverlayPlanes* OverlayPlanes();
+  // Commits the overlay planes scheduled for the frame about to be swapped.
+  void CommitOverlayPlanes();
+
   // Immediately Resizes window and flushes Wayland Display.
   void Resize(unsigned width, unsigned height);
   void Move(ShellType type,
             WaylandShellSurface* shell_parent,
             const gfx::Rect& rect);
-  void AddRegion(int left, int top, int right, int bottom);
-  void SubRegion(int left, int top, int right, int bottom);
+  // Sets the opaque and input regions of the surface. They take effect with
+  // the next commit. See WaylandDisplay_SetRegion for the meaning of empty
+  // lists.
+  void SetRegion(const std::vector<gfx::Rect>& opaque_region,
+                 const std::vector<gfx::Rect>& input_region);
   gfx::Rect GetBounds() const { return allocation_; }
 
  private:
+  // Returns a new region covering |rects|, NULL if |rects| is empty. The
+  // caller owns the region.
+  static struct wl_region* CreateRegion(const std::vector<gfx::Rect>& rects);
+
   WaylandShellSurface* shell_surface_;
   EGLWindow* window_;
+  WaylandShmSurface* shm_surface_;
+  WaylandOverlayPlanes* overlay_planes_;
 
   ShellType type_;
   unsigned handle_;